@@ -2,26 +2,82 @@
 #define SHADER_H
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <glm/glm.hpp>
 
+// Slot of a uniform in the shader's cache; look it up once, reuse every frame
+struct UniformHandle {
+    int slot = -1;
+    bool valid() const { return slot >= 0; }
+};
+
 class Shader {
 public:
     unsigned int ID;
 
     // Load, compile, and link shaders
     Shader(const char* vertexPath, const char* fragmentPath);
+    // Take ownership of an already linked program
+    explicit Shader(unsigned int program);
     void use() const;
 
-    // Set uniform values
-    void setMat4(const std::string &name, const glm::mat4 &mat) const;
-    void setVec3(const std::string &name, const glm::vec3 &vec) const;
-    void setFloat(const std::string &name, float value) const;
-    void setInt(const std::string &name, int value) const;
+    // Replace the program (e.g. a fallback by the real one once it is built).
+    // Valid uniform handles stay valid and block bindings are re-applied;
+    // uniforms the old program lacked need looking up again.
+    void adopt(unsigned int program);
+
+    // Bumped by every adopt(): handles cached at another generation may be
+    // missing uniforms the new program has
+    unsigned int generation() const { return programGeneration; }
+
+    // Attach a uniform block to a binding point (no-op if the program lacks it)
+    void bindUniformBlock(const char* block, unsigned int binding);
+
+    // Point a sampler uniform at a texture unit (no-op if the program lacks it)
+    void bindSampler(const char* sampler, int unit);
+
+    // Find a uniform by name (invalid handle if the program has no such uniform)
+    UniformHandle uniform(const char* name) const;
+
+    // Set uniform values by handle; the GL call is skipped if the value is unchanged
+    void setMat4(UniformHandle h, const glm::mat4 &mat) const;
+    void setMat3(UniformHandle h, const glm::mat3 &mat) const;
+    void setVec3(UniformHandle h, const glm::vec3 &vec) const;
+    void setFloat(UniformHandle h, float value) const;
+    void setInt(UniformHandle h, int value) const;
+
+    // Set uniform values by name
+    void setMat4(const char* name, const glm::mat4 &mat) const { setMat4(uniform(name), mat); }
+    void setMat3(const char* name, const glm::mat3 &mat) const { setMat3(uniform(name), mat); }
+    void setVec3(const char* name, const glm::vec3 &vec) const { setVec3(uniform(name), vec); }
+    void setFloat(const char* name, float value) const { setFloat(uniform(name), value); }
+    void setInt(const char* name, int value) const { setInt(uniform(name), value); }
+
+    // Read a whole source file ("" and an error message if it is missing)
+    static std::string readFile(const char* path);
+    // Compile and link a program from sources; 0 if anything fails
+    static unsigned int link(const std::string& vertexCode, const std::string& fragmentCode);
 
 private:
-    std::string readFile(const char* path);
-    void checkCompileErrors(unsigned int shader, const std::string& type);
+    // Location and last uploaded value of one active uniform
+    struct UniformSlot {
+        int   location;
+        int   size;        // value size in floats
+        bool  hasValue;
+        float value[16];
+    };
+    unsigned int programGeneration = 0;
+    mutable std::vector<UniformSlot> slots;
+    std::vector<std::pair<std::string, int>> slotByName;   // sorted by name
+    std::vector<std::pair<std::string, unsigned int>> blockBindings;
+    std::vector<std::pair<std::string, int>> samplerBindings;
+
+    static bool checkCompileErrors(unsigned int shader, const std::string& type);
+    void cacheUniforms();
+    // True if the slot already holds this value; otherwise stores it
+    bool unchanged(UniformHandle h, const void* data, int floats) const;
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+
+// Global operator new is replaced by a counting one (alloc_counter.cpp).
+// Heap allocations made by the calling thread since it started; take the
+// difference around a frame to see what it allocated.
+std::uint64_t threadAllocations();
@@ -0,0 +1,128 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "Shader.h"
+#include "shader_cache.h"
+
+// Frame-time statistics in milliseconds
+struct TimingSummary {
+    double min  = 0.0;
+    double mean = 0.0;
+    double p50  = 0.0;
+    double p95  = 0.0;
+    double p99  = 0.0;
+};
+
+// Reduce a list of samples to min/mean/percentiles
+TimingSummary summarize(std::vector<double> samples);
+
+// Colour + depth framebuffer used instead of a window in headless runs
+class OffscreenTarget {
+public:
+    OffscreenTarget();
+
+    bool init(int width, int height);
+    void destroy();
+    void bind() const;
+
+private:
+    GLuint fbo, colorRBO, depthRBO;
+};
+
+// GPU frame timer built on GL_TIME_ELAPSED queries.
+// Results are read back a few frames late so the pipeline never stalls.
+class GpuTimer {
+public:
+    GpuTimer();
+
+    void init();
+    void destroy();
+
+    void begin();
+    void end();
+
+    // Move every finished result (ms) into out; wait=true drains all pending queries
+    void collect(std::vector<double>& out, bool wait = false);
+
+    // Times begin() found every query in flight and had to wait for the oldest
+    int stalls() const { return ringStalls; }
+
+private:
+    static const int kQueries = 4;
+    GLuint queries[kQueries];
+    int    head;     // next query to issue
+    int    pending;  // issued but not yet read
+    int    ringStalls;
+
+    // Results read by begin() to free a query, handed out by the next collect()
+    std::vector<double> held;
+
+    void read(std::vector<double>& out, bool wait);
+};
+
+// Accumulates benchmark cases and writes them as JSON
+class BenchReport {
+public:
+    void addCase(const std::string& name,
+                 const std::vector<double>& cpuMs,
+                 const std::vector<double>& gpuMs);
+    void addMetric(const std::string& name, double value);
+
+    // Write to path, or stdout if path is empty
+    bool write(const std::string& path) const;
+
+private:
+    struct Case {
+        std::string   name;
+        int           frames;
+        TimingSummary cpu, gpu;
+    };
+    std::vector<Case> cases;
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+// CPU microbenchmark: forward kinematics throughput for a crowd of robots
+void benchForwardKinematics(BenchReport& report, int robots, int iterations);
+
+// CPU microbenchmark: crowd animation + transform building on 1..N threads
+void benchJobScaling(BenchReport& report, int robots, int iterations);
+
+// CPU microbenchmark: BVH refit + frustum cull of a crowd seen from its edge
+void benchCulling(BenchReport& report, int robots, int iterations);
+
+// CPU check: jungle chunks far from the origin (where the chunk hash wraps)
+// generate the same plants every time. Returns false if one differs.
+bool benchVegetationDeterminism(BenchReport& report);
+
+// CPU microbenchmark: Robot::draw for a grid of robots plus Scene::draw of
+// every scene, queued and flushed into a RecordingDevice so submission is
+// timed without a driver, with the calls and heap allocations it made per
+// frame. Meshes missing from the registry are built on the recording device:
+// run it before any GL mesh exists or after every mesh is built
+// (Robot::initGPU, Scene::ensureGround). Returns false if the device's calls
+// differ from the queue's counters or exceed the per-frame budget (no buffer
+// creations or uploads, bounded program and VAO binds).
+bool benchSubmission(BenchReport& report, int robots, int frames);
+
+// GL microbenchmark: streaming instances of instanceBytes each per frame with
+// glBufferData reallocation vs. StreamBuffer (orphan and, if available,
+// persistent mapping). Needs a current context; each upload is drawn as one
+// point with the given program.
+void benchStreamUpload(BenchReport& report, GLuint program, int instances, int instanceBytes, int frames);
+
+// GL microbenchmark: a grid of tiny dense spheres, so the vertex stage
+// dominates, drawn with the old per-vertex inverse() program (uModel, see
+// SHADER_VERTEX_INVERSE) and with the per-draw uModelView/uNormalMatrix one.
+// Needs a current context with FrameBlock holding this view matrix.
+void benchVertexTransforms(BenchReport& report, Shader& perVertex, Shader& perDraw,
+                           const glm::mat4& view, int spheres, int frames);
+
+// GL microbenchmark: fly across the jungle grid under a small memory budget,
+// streaming chunks in and evicting them. Needs a current context.
+void benchVegetationStreaming(BenchReport& report, int frames);
+
+// GL microbenchmark: build every program with an empty binary cache, then
+// again with the binaries on disk. Needs a current context.
+void benchShaderCache(BenchReport& report, const std::vector<ProgramSource>& programs);
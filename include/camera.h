@@ -21,6 +21,9 @@ public:
     // Handle mouse rotation
     void processMouse(float xoffset, float yoffset);
 
+    // Blend position and orientation of two cameras (t = 0 gives a, t = 1 gives b)
+    static Camera lerp(const Camera& a, const Camera& b, float t);
+
 private:
     glm::vec3 Position;
     glm::vec3 Front;
@@ -0,0 +1,100 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "culling.h"
+#include "job_system.h"
+
+// Froxel grid: screen tiles in x/y, exponential depth slices in z
+static const int kClusterX = 16;
+static const int kClusterY = 9;
+static const int kClusterZ = 24;
+static const int kClusterCount = kClusterX * kClusterY * kClusterZ;
+
+// Texture units of the light buffers (samplers uLightData, uLightGrid, uLightIndices)
+enum ClusterTextureUnit : GLint {
+    LIGHT_DATA_UNIT  = 4,   // RGBA32F, two texels per light: view position + radius, colour
+    LIGHT_GRID_UNIT  = 5,   // RG32UI per cluster: first index, light count
+    LIGHT_INDEX_UNIT = 6    // R32UI light indices, grouped by cluster
+};
+
+// Lights one build accepts (indices are packed in 16 bits)
+static const int kMaxClusteredLights = 65535;
+
+// A point light in world space; it reaches nothing beyond radius
+struct PointLight {
+    glm::vec3 position;
+    float     radius;
+    glm::vec3 color;
+};
+
+// CPU mirror of the std140 ClusterBlock declared in the fragment shader
+struct ClusterConstants {
+    glm::uvec4 dims;     // kClusterX, kClusterY, kClusterZ, lights
+    glm::vec4  params;   // slice scale, slice bias, tile width / height in pixels
+};
+static_assert(sizeof(ClusterConstants) == 32, "ClusterConstants must match std140 ClusterBlock");
+
+struct ClusterStats {
+    int    lights        = 0;   // lights submitted
+    int    visibleLights = 0;   // lights touching at least one cluster
+    int    indices       = 0;   // entries in the index list
+    int    maxPerCluster = 0;
+    double buildMs       = 0.0; // CPU time of the last build
+};
+
+// Clustered forward lighting. Every frame the lights are assigned to the
+// view-space froxels they overlap (one job per depth slice) and the result
+// goes to three buffer textures; the CLUSTERED fragment shader finds its
+// froxel from gl_FragCoord and depth and only loops over that froxel's lights.
+class ClusteredLights {
+public:
+    ClusteredLights();
+
+    void init();
+    void destroy();
+
+    // Assign lights to clusters and upload the buffers; returns the block
+    // constants for this view (the caller owns the ClusterBlock UBO).
+    // Scratch for the build comes from `scratch` (e.g. the frame arena).
+    ClusterConstants build(const std::vector<PointLight>& lights,
+                           const glm::mat4& view, const glm::mat4& proj,
+                           float zNear, float zFar, int width, int height, JobSystem& jobs,
+                           std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+    // Bind the three buffer textures to their units
+    void bind() const;
+
+    const ClusterStats& stats() const { return counters; }
+
+private:
+    // View-space light, with the froxel range it may touch
+    struct LightRange {
+        glm::vec3 position;
+        float     radius;
+        int       x0, x1, y0, y1, z0, z1;
+    };
+
+    GLuint buffers[3];
+    GLuint textures[3];
+
+    // Froxel bounds, rebuilt when the projection changes
+    glm::mat4         boundsProj;
+    float             boundsNear, boundsFar;
+    std::vector<AABB> bounds;
+
+    // Per-frame scratch, kept to avoid reallocating
+    std::vector<LightRange>                 ranges;
+    std::vector<glm::vec4>                  lightData;
+    std::vector<std::vector<std::uint32_t>> slicePairs;   // per slice: cell << 16 | light, sorted
+    std::vector<glm::uvec2>                 grid;
+    std::vector<std::uint32_t>              indices;
+
+    ClusterStats counters;
+
+    void buildBounds(const glm::mat4& proj, float zNear, float zFar);
+    void assignSlice(int z);
+    static void upload(GLuint buffer, const void* data, size_t bytes);
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <vector>
+
+// Axis-aligned bounding box; default-constructed boxes are empty
+struct AABB {
+    glm::vec3 min = glm::vec3( FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool empty() const { return min.x > max.x; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+    void expand(const AABB& b)      { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+};
+
+// Bounds of a local box after an affine transform
+AABB transformBounds(const glm::mat4& m, const AABB& local);
+
+enum class Containment { Outside, Intersects, Inside };
+
+// View frustum as six planes, stored structure-of-arrays so one SSE
+// instruction tests a box against four planes at once
+class Frustum {
+public:
+    // Accepts everything
+    Frustum();
+    // Planes of a view-projection matrix (GL clip space, -w..w)
+    explicit Frustum(const glm::mat4& viewProj);
+
+    Containment classify(const AABB& box) const;
+    bool visible(const AABB& box) const { return classify(box) != Containment::Outside; }
+
+private:
+    // 6 planes padded to 8 with planes that pass everything
+    alignas(16) float nx[8], ny[8], nz[8], d[8];
+    alignas(16) float ax[8], ay[8], az[8];   // |normal|
+};
+
+// Per-frame culling counters (leaves only; tests counts every box tested)
+struct CullStats {
+    int visible = 0;
+    int culled  = 0;
+    int tests   = 0;
+
+    void add(const CullStats& o) { visible += o.visible; culled += o.culled; tests += o.tests; }
+};
+
+// Bounding-volume hierarchy over a fixed set of boxes. The topology is built
+// once; refit() updates node bounds bottom-up when the boxes move.
+class Bvh {
+public:
+    void build(const std::vector<AABB>& boxes);
+    void refit(const AABB* boxes);
+
+    // Append the index of every box touching the frustum to visible
+    void cull(const Frustum& frustum, std::vector<int>& visible, CullStats& stats) const;
+
+    int size() const { return (int)items.size(); }
+    // Bounds of everything in the tree
+    AABB bounds() const { return nodes.empty() ? AABB() : nodes[0].box; }
+
+private:
+    // Children always come after their parent. Every node covers the
+    // contiguous range [first, first + count) of order.
+    struct Node {
+        AABB box;
+        int  left  = -1;   // -1 for leaves; the right child is stored at `right`
+        int  right = -1;
+        int  first = 0;
+        int  count = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int>  order;   // box indices in tree order
+    std::vector<AABB> items;   // latest box of every index
+
+    int buildNode(int first, int count);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that only lives for one frame. Nothing is freed
+// individually; reset() drops everything at once and keeps the memory.
+// If a frame overflows the block, the next reset() grows it to the peak.
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t capacity = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(std::size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Release every allocation of the frame
+    void reset();
+
+    // std::pmr view of the arena: std::pmr containers built on it allocate
+    // here, their deallocations do nothing and reset() takes the memory back
+    std::pmr::memory_resource* resource() { return &adapter; }
+
+    std::size_t used() const { return offset + overflowBytes; }
+    std::size_t capacity() const { return size; }
+
+private:
+    struct Resource : std::pmr::memory_resource {
+        FrameArena* arena;
+        explicit Resource(FrameArena* a) : arena(a) {}
+        void* do_allocate(std::size_t bytes, std::size_t align) override { return arena->allocate(bytes, align); }
+        void  do_deallocate(void*, std::size_t, std::size_t) override {}
+        bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::unique_ptr<unsigned char[]> block;
+    std::size_t size;
+    std::size_t offset;
+
+    // Allocations that did not fit this frame
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    std::size_t overflowBytes;
+
+    Resource adapter;
+};
+
+// Two arenas used on alternate frames: beginFrame() resets the one the
+// previous-but-one frame used, so anything allocated last frame is still
+// valid while this one is built (render thread only)
+class FrameMemory {
+public:
+    explicit FrameMemory(std::size_t capacity = 64 * 1024);
+
+    void beginFrame();
+
+    FrameArena&                current() { return arenas[index]; }
+    std::pmr::memory_resource* resource() { return arenas[index].resource(); }
+
+    // Bytes in use / reserved by both arenas
+    std::size_t used() const { return arenas[0].used() + arenas[1].used(); }
+    std::size_t capacity() const { return arenas[0].capacity() + arenas[1].capacity(); }
+
+private:
+    FrameArena arenas[2];
+    int        index;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Readbacks in flight; a frame is mapped kCapturePbos - 1 frames after it was read
+static const int kCapturePbos = 3;
+
+enum class CaptureFormat {
+    PNG,   // one frame_NNNNNN.png per frame in a directory
+    Y4M    // one raw YUV 4:2:0 stream
+};
+
+struct CaptureSettings {
+    std::string   path;              // directory (PNG) or .y4m file
+    CaptureFormat format     = CaptureFormat::PNG;
+    int           workers    = 2;    // encoder threads
+    int           queueDepth = 8;    // frames waiting for an encoder
+    int           fps        = 60;   // Y4M header only
+    bool          lossless   = false; // wait for the GPU and encoders instead of dropping (replays)
+};
+
+struct CaptureStats {
+    int    frames          = 0;     // capture() calls
+    int    queued          = 0;     // frames handed to the encoders
+    int    written         = 0;     // frames on disk
+    int    droppedReadback = 0;     // every PBO still waiting for the GPU
+    int    droppedQueue    = 0;     // encoder queue full
+    double captureMsTotal  = 0.0;   // render-thread time spent in capture()
+    double captureMsMax    = 0.0;
+    double encodeMsTotal   = 0.0;   // worker time spent encoding and writing
+};
+
+// Records the framebuffer without stalling the render loop. Each frame is
+// read into one of a ring of pixel pack buffers; a buffer is mapped only once
+// its fence has passed, copied into a free slot of a bounded frame pool and
+// handed to encoder threads (PNG via stb_image_write, or a Y4M stream).
+// When the PBOs or the pool are all busy the frame is dropped and counted
+// instead of waiting, unless the capture is lossless.
+class FrameCapture {
+public:
+    FrameCapture();
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Capture width x height from the read framebuffer from now on; false if
+    // the output cannot be opened
+    bool start(int width, int height, const CaptureSettings& settings);
+
+    // Finish in-flight readbacks, encode everything queued and close the output
+    void stop();
+
+    // After the frame is rendered (before the swap)
+    void capture();
+
+    bool active() const { return running; }
+    CaptureStats stats() const;
+
+    // Format from a path: ".y4m" is a stream, anything else a PNG directory
+    static CaptureFormat formatFor(const std::string& path);
+
+private:
+    struct Readback {
+        GLuint pbo   = 0;
+        GLsync fence = nullptr;
+    };
+    struct Job {
+        int           slot;       // frame pool slot
+        std::uint64_t sequence;   // order of frames handed to the encoders
+    };
+
+    CaptureSettings config;
+    int  width, height;
+    bool running;
+
+    // Readback ring (GL thread only)
+    Readback readbacks[kCapturePbos];
+    int      oldest, inFlight;
+
+    // Frame pool: slot pixels, top row first, RGBA
+    std::vector<std::vector<unsigned char>> pool;
+    std::vector<int>                        freeSlots;
+    std::uint64_t                           nextSequence;
+
+    // Encoder threads and their queue
+    std::vector<std::thread> workers;
+    std::deque<Job>          queue;
+    mutable std::mutex       mutex;
+    std::condition_variable  wake;
+    std::condition_variable  slotFreed;
+    bool                     quit;
+
+    // Y4M output, written in sequence order under its own lock so a slow
+    // disk never blocks capture()
+    std::FILE*              stream;
+    std::mutex              streamMutex;
+    std::condition_variable streamTurn;
+    std::uint64_t           nextWrite;
+
+    CaptureStats counters;
+
+    // Map finished readbacks and queue them; wait = block on their fences
+    void collect(bool wait);
+    void workerLoop();
+    void encode(const Job& job, std::vector<unsigned char>& scratch);
+};
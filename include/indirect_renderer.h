@@ -0,0 +1,69 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Shader.h"
+#include "mesh_registry.h"
+
+// SSBO binding of the per-draw data (layout(binding = 0) in indirect_vertex_shader.glsl)
+static const GLuint kDrawDataBinding = 0;
+
+// Per-draw data read by indirect_vertex_shader.glsl (std430)
+struct IndirectDrawData {
+    glm::mat4 modelView;
+    glm::vec4 normal[3];   // mat3 columns, each padded to a vec4
+    glm::vec4 color;
+};
+
+// Whole-frame submission through glMultiDrawElementsIndirect (GL 4.3+).
+// Every draw becomes one command in a buffer; its baseInstance indexes the
+// per-draw data in an SSBO, so one call draws any number of meshes.
+class IndirectRenderer {
+public:
+    IndirectRenderer();
+
+    // Load the GL 4.3 entry points; false if the context is older,
+    // in which case callers keep the per-draw path
+    bool init(GLADloadproc load);
+    void destroy();
+    bool available() const { return ready; }
+
+    // Record one draw of a mesh
+    void add(const Mesh& mesh, const glm::mat4& modelView, const glm::mat3& normal, const glm::vec3& color);
+
+    // Upload commands and draw data, issue one multi-draw per primitive mode,
+    // and clear the lists. The indirect program must be given.
+    void submit(Shader& program);
+
+    // Multi-draw calls issued by the last submit()
+    int drawCalls() const { return lastDrawCalls; }
+
+private:
+    // Layout fixed by the GL spec
+    struct Command {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+    // Commands sharing one primitive mode
+    struct ModeList {
+        GLenum               mode;
+        std::vector<Command> commands;
+    };
+
+    bool   ready;
+    GLuint vao;            // shared geometry + per-draw id attribute
+    GLuint drawIdBuffer;   // 0, 1, 2, ... read with divisor 1 via baseInstance
+    GLuint commandBuffer;
+    GLuint drawDataBuffer;
+    GLsizei capacity;      // draws the id buffer covers
+    int    lastDrawCalls;
+
+    std::vector<IndirectDrawData> draws;
+    std::vector<ModeList>         lists;
+    std::vector<Command>          packed;   // all lists back to back for upload
+
+    void reserve(GLsizei draws);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+// Input logs record what every simulation step consumed, keyed by its tick,
+// so a replay reproduces the exact same sequence of states.
+//
+// File: "RIN1", u32 step rate (Hz), u64 step count, then one event per step
+// whose input differs from "keys held, nothing else":
+//   varint ticks since the previous event, u8 field mask, then per mask bit
+//   held keys (u8), mouse delta (2 x f32), scene (u8), camera mode (u8).
+// Held keys last until the next keys event; the other fields apply to one step.
+
+// Simulation thread: collects the log in memory while recording
+class InputRecorder {
+public:
+    void begin(double hz);
+
+    // Input consumed by the step that advances `tick` to tick + 1
+    void record(std::uint64_t tick, const InputState& input);
+
+    // After the simulation has stopped
+    bool save(const std::string& path) const;
+
+    bool          recording() const { return active; }
+    std::uint64_t steps() const { return stepCount; }
+    size_t        bytes() const { return events.size(); }
+
+private:
+    std::vector<std::uint8_t> events;
+    std::uint32_t rate      = 0;
+    std::uint64_t stepCount = 0;
+    std::uint64_t lastEvent = 0;
+    std::uint8_t  heldKeys  = 0;
+    bool          active    = false;
+};
+
+// Plays a log back on a virtual clock: every frame advances exactly
+// frameSeconds and the steps due by then run stepSimulation with the logged
+// input, so the same log renders the same frames on every run and machine
+class InputReplay {
+public:
+    bool load(const std::string& path);
+
+    void start(const SimState& initial);
+
+    // State to render for the next frame, one step behind like Simulation::sample
+    SimState frame(double frameSeconds);
+
+    // Every logged step has run and been rendered
+    bool finished() const { return state.tick >= stepCount && caughtUp; }
+
+    double        hz() const { return rate; }
+    std::uint64_t steps() const { return stepCount; }
+    std::uint64_t frames() const { return frameCount; }
+
+private:
+    std::vector<std::uint8_t> events;
+    std::uint32_t rate      = 0;
+    std::uint64_t stepCount = 0;
+
+    // Decoder
+    size_t        cursor    = 0;
+    std::uint64_t nextEvent = 0;    // tick of the event at cursor
+    bool          hasEvent  = false;
+    std::uint8_t  heldKeys  = 0;
+
+    // Virtual-clock simulation
+    SimState      state, previous;
+    std::uint64_t frameCount = 0;
+    bool          caughtUp   = false;   // last frame showed the newest step unblended
+
+    void readEventTick();
+    InputState inputFor(std::uint64_t tick);
+};
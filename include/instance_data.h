@@ -0,0 +1,18 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Per-instance data read by the INSTANCED vertex_shader.glsl (attributes 2..9);
+// shared by everything drawn with that program
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normal;   // inverse-transpose of the model 3x3 (world space)
+    glm::vec3 color;
+};
+
+// Turn on attributes 2..9 with divisor 1 in the bound VAO
+void enableInstanceAttributes();
+
+// Point attributes 2..9 at InstanceData starting at offset in the bound
+// GL_ARRAY_BUFFER; the VAO must be bound
+void setInstanceLayout(GLintptr offset);
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing scheduler. Every thread (the caller included) owns a
+// deque: it pops its own work from the back and steals from others' fronts.
+class JobSystem {
+public:
+    // workers < 0: one worker per hardware thread besides the caller
+    explicit JobSystem(int workers = -1);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads that execute jobs, including the calling thread
+    int threadCount() const { return (int)queues.size(); }
+
+    // Call fn(chunkBegin, chunkEnd) over [begin, end) in chunks of `grain`
+    // and return once every chunk has run. The caller works too.
+    template <typename Fn>
+    void parallelFor(int begin, int end, int grain, Fn&& fn) {
+        auto invoke = [](void* ctx, int b, int e) { (*static_cast<Fn*>(ctx))(b, e); };
+        dispatch(begin, end, grain, invoke, &fn);
+    }
+
+private:
+    struct Job {
+        void (*invoke)(void*, int, int);
+        void* ctx;
+        int   begin, end;
+        std::atomic<int>* pending;
+    };
+    // Deque as a ring that only grows, so dispatching never allocates once
+    // it has seen its largest batch
+    struct Queue {
+        std::mutex       m;
+        std::vector<Job> ring;
+        size_t           head  = 0;
+        size_t           count = 0;
+
+        void pushBack(const Job& job);
+        Job  popBack();
+        Job  popFront();
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;   // [0] belongs to the caller
+    std::vector<std::thread>            workers;
+
+    std::mutex              sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int>        queued;
+    std::atomic<bool>       quit;
+
+    void dispatch(int begin, int end, int grain,
+                  void (*invoke)(void*, int, int), void* ctx);
+    bool popOrSteal(int self, Job& job);
+    void run(Job& job);
+    void workerLoop(int self);
+};
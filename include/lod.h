@@ -0,0 +1,34 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "skeleton.h"
+
+// Tessellation levels per curved primitive; level 0 is the authored detail
+static const int kLodLevels = 3;
+
+// Tessellation of a part at a LOD level (0 stays 0 for flat primitives)
+int lodTessellation(int fullTessellation, int level);
+
+// What the LOD selector needs to know about the camera
+struct LodView {
+    glm::vec3 eye        = glm::vec3(0.0f);
+    float     pixelScale = 0.0f;   // pixels covered by 1 world unit at distance 1; 0 = full detail
+};
+
+LodView makeLodView(const glm::mat4& view, const glm::mat4& proj, int viewportHeight);
+
+// Projected diameter in pixels of an object of the given world diameter
+float projectedPixels(const LodView& lod, const glm::vec3& center, float diameter);
+
+// Level for a projected size. `current` is the level used last frame (-1 if
+// none); the level only changes once the size is a margin past a boundary,
+// so objects sitting on a threshold do not pop back and forth.
+int selectLod(float pixels, int current);
+
+// World-space diameter of a part (joints are rigid, so it never changes)
+float partDiameter(const Skeleton& skeleton, int part);
+
+// Instances and triangles submitted per level in the last frame
+struct LodStats {
+    int       instances[kLodLevels] = {};
+    long long triangles[kLodLevels] = {};
+};
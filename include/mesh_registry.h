@@ -0,0 +1,87 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "culling.h"
+
+// Primitive shapes used to build the robot and the scene
+enum class Primitive {
+    Cube,     // unit cube centred on the origin
+    Sphere,   // unit-radius sphere
+    Tube,     // open unit cylinder along Z (radius 1, z in [-0.5, 0.5])
+    Disc,     // unit disc in the XY plane (cylinder cap)
+    Pyramid,  // square base [-1,1] on XZ, apex at y = 1
+    Quad      // square [-1,1] on XZ facing +Y (ground)
+};
+
+// The one vertex format of every static mesh
+struct MeshVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+// A range of the shared index/vertex buffers
+struct Mesh {
+    GLuint  vao        = 0;   // the registry's VAO
+    GLenum  mode       = GL_TRIANGLES;
+    GLsizei count      = 0;   // indices
+    GLuint  firstIndex = 0;   // offset into the index buffer
+    GLint   baseVertex = 0;   // offset into the vertex buffer
+};
+
+// Holds every static mesh in one interleaved vertex buffer and one index
+// buffer behind a single VAO; meshes are drawn by offset with base-vertex
+// calls. Each primitive is generated once per (type, tessellation); size is
+// applied through the model matrix, never by re-tessellating.
+class MeshRegistry {
+public:
+    MeshRegistry();
+
+    // Allocate the shared buffers (done on first use with the default sizes)
+    void init(GLsizei vertexCapacity = 1 << 16, GLsizei indexCapacity = 1 << 18);
+    // Free the buffers and forget every mesh
+    void destroy();
+
+    // Get (building on first use) the mesh for a primitive/tessellation pair
+    const Mesh& get(Primitive type, int tessellation = 0);
+
+    // Copy other static geometry into the shared buffers
+    Mesh add(const std::vector<MeshVertex>& vertices, const std::vector<GLuint>& indices, GLenum mode);
+
+    // VAO over the shared buffers that every Mesh draws through
+    GLuint vertexArray() const { return vao; }
+    // New VAO over the shared buffers, left bound so callers can add instance attributes
+    GLuint makeVertexArray() const;
+
+    // GPU memory in use / reserved by the shared buffers
+    std::size_t usedBytes() const;
+    std::size_t capacityBytes() const;
+    int meshCount() const { return meshesAdded; }
+
+    // Object-space bounds of a primitive (independent of tessellation)
+    static AABB localBounds(Primitive type);
+
+    // Triangles one draw of the mesh rasterises
+    static GLsizei triangleCount(const Mesh& mesh);
+
+    // Bind and draw a mesh
+    static void draw(const Mesh& mesh);
+    // Draw a mesh through a VAO from makeVertexArray
+    static void drawInstanced(const Mesh& mesh, GLuint vao, GLsizei instances);
+
+private:
+    GLuint  vao, vbo, ebo;
+    GLsizei vertexCapacity, indexCapacity;
+    GLsizei vertexCount, indexCount;
+    int     meshesAdded;
+
+    std::unordered_map<std::uint64_t, Mesh> meshes;
+
+    static std::uint64_t key(Primitive type, int tessellation);
+};
+
+// The registry shared by everything that draws static geometry
+MeshRegistry& meshRegistry();
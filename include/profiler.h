@@ -0,0 +1,82 @@
+#pragma once
+
+// CPU and GPU scope profiler with Chrome trace_event export
+// (open the file in chrome://tracing or ui.perfetto.dev).
+//
+//   PROFILE_SCOPE("name")      time the enclosing block on this thread
+//   PROFILE_GPU_SCOPE("name")  time the GL commands of the block (GL thread only)
+//
+// Built with ROBOT_PROFILE=0 every macro expands to nothing.
+
+#ifndef ROBOT_PROFILE
+#define ROBOT_PROFILE 0
+#endif
+
+#if ROBOT_PROFILE
+
+#include <cstdint>
+#include <string>
+
+// Records [construction, destruction) into the calling thread's ring buffer.
+// name must outlive the profiler (use string literals).
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char*  name;
+    std::int64_t start;
+};
+
+// Brackets GL commands with timestamp queries; results are read back
+// kGpuFrames frames later so the CPU never waits for the GPU
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name);
+    ~GpuProfileScope();
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    int slot;   // -1 if the scope is not recorded
+};
+
+// Label the calling thread in the trace ("worker 3" with index 3)
+void profileThreadName(const char* name, int index = -1);
+
+// GL-side setup/teardown; needs a current context
+void profileInitGpu();
+void profileShutdownGpu();
+
+// Once per frame on the GL thread: collect finished GPU scopes
+void profileEndFrame();
+
+// Write everything still in the ring buffers as trace_event JSON
+bool profileWriteTrace(const std::string& path);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name)        ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name)    GpuProfileScope PROFILE_CONCAT(profileGpuScope_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(...)   profileThreadName(__VA_ARGS__)
+#define PROFILE_INIT_GPU()         profileInitGpu()
+#define PROFILE_SHUTDOWN_GPU()     profileShutdownGpu()
+#define PROFILE_END_FRAME()        profileEndFrame()
+#define PROFILE_WRITE_TRACE(path)  profileWriteTrace(path)
+
+#else
+
+#define PROFILE_SCOPE(name)        ((void)0)
+#define PROFILE_GPU_SCOPE(name)    ((void)0)
+#define PROFILE_THREAD_NAME(...)   ((void)0)
+#define PROFILE_INIT_GPU()         ((void)0)
+#define PROFILE_SHUTDOWN_GPU()     ((void)0)
+#define PROFILE_END_FRAME()        ((void)0)
+#define PROFILE_WRITE_TRACE(path)  ((void)0)
+
+#endif
@@ -0,0 +1,181 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The GL calls of the draw path (mesh registry, shader uniforms, render
+// queue) behind one interface, so submission can run without a context.
+// Everything else (instancing, streaming, capture) still calls GL directly.
+class RenderDevice {
+public:
+    virtual ~RenderDevice() = default;
+
+    // Buffers
+    virtual GLuint createBuffer() = 0;
+    virtual void   deleteBuffer(GLuint buffer) = 0;
+    virtual void   bindBuffer(GLenum target, GLuint buffer) = 0;
+    virtual void   bufferData(GLenum target, GLsizeiptr bytes, const void* data, GLenum usage) = 0;
+    virtual void   bufferSubData(GLenum target, GLintptr offset, GLsizeiptr bytes, const void* data) = 0;
+
+    // Vertex arrays
+    virtual GLuint createVertexArray() = 0;
+    virtual void   deleteVertexArray(GLuint vao) = 0;
+    virtual void   bindVertexArray(GLuint vao) = 0;
+    // Enable float attribute `index` of the bound VAO from the bound array buffer
+    virtual void   vertexAttribute(GLuint index, GLint size, GLsizei stride, std::size_t offset) = 0;
+
+    // Programs
+    virtual void  useProgram(GLuint program) = 0;
+    virtual void  deleteProgram(GLuint program) = 0;
+    // Every active uniform with its location (-1 for block members); arrays as "name[0]"
+    virtual void  activeUniforms(GLuint program, std::vector<std::pair<std::string, GLint>>& out) = 0;
+    virtual GLint uniformLocation(GLuint program, const char* name) = 0;
+    // No-op if the program has no such block
+    virtual void  uniformBlockBinding(GLuint program, const char* block, GLuint binding) = 0;
+    virtual void  programUniform1i(GLuint program, GLint location, GLint value) = 0;
+
+    // Uniforms of the program in use
+    virtual void uniformMatrix4(GLint location, const float* value) = 0;
+    virtual void uniformMatrix3(GLint location, const float* value) = 0;
+    virtual void uniform3(GLint location, const float* value) = 0;
+    virtual void uniform1f(GLint location, float value) = 0;
+    virtual void uniform1i(GLint location, GLint value) = 0;
+
+    // Indexed draws from the bound VAO (32-bit indices)
+    virtual void drawElements(GLenum mode, GLsizei count, GLuint firstIndex, GLint baseVertex) = 0;
+    virtual void drawElementsInstanced(GLenum mode, GLsizei count, GLuint firstIndex,
+                                       GLsizei instances, GLint baseVertex) = 0;
+};
+
+// Straight glad calls; needs a current context
+class GlDevice : public RenderDevice {
+public:
+    GLuint createBuffer() override;
+    void   deleteBuffer(GLuint buffer) override;
+    void   bindBuffer(GLenum target, GLuint buffer) override;
+    void   bufferData(GLenum target, GLsizeiptr bytes, const void* data, GLenum usage) override;
+    void   bufferSubData(GLenum target, GLintptr offset, GLsizeiptr bytes, const void* data) override;
+
+    GLuint createVertexArray() override;
+    void   deleteVertexArray(GLuint vao) override;
+    void   bindVertexArray(GLuint vao) override;
+    void   vertexAttribute(GLuint index, GLint size, GLsizei stride, std::size_t offset) override;
+
+    void  useProgram(GLuint program) override;
+    void  deleteProgram(GLuint program) override;
+    void  activeUniforms(GLuint program, std::vector<std::pair<std::string, GLint>>& out) override;
+    GLint uniformLocation(GLuint program, const char* name) override;
+    void  uniformBlockBinding(GLuint program, const char* block, GLuint binding) override;
+    void  programUniform1i(GLuint program, GLint location, GLint value) override;
+
+    void uniformMatrix4(GLint location, const float* value) override;
+    void uniformMatrix3(GLint location, const float* value) override;
+    void uniform3(GLint location, const float* value) override;
+    void uniform1f(GLint location, float value) override;
+    void uniform1i(GLint location, GLint value) override;
+
+    void drawElements(GLenum mode, GLsizei count, GLuint firstIndex, GLint baseVertex) override;
+    void drawElementsInstanced(GLenum mode, GLsizei count, GLuint firstIndex,
+                               GLsizei instances, GLint baseVertex) override;
+};
+
+enum class DeviceOp : std::uint8_t {
+    CreateBuffer, DeleteBuffer, BindBuffer, BufferData, BufferSubData,
+    CreateVertexArray, DeleteVertexArray, BindVertexArray, VertexAttribute,
+    UseProgram, DeleteProgram, UniformBlockBinding, Uniform,
+    Draw, DrawInstanced
+};
+
+// One recorded call. object is the buffer, VAO or program (the uniform
+// location for Uniform, the primitive mode for draws); size is bytes for
+// uploads, floats for uniforms, components for attributes and indices for draws
+struct DeviceCommand {
+    DeviceOp     op;
+    GLenum       target;   // buffer target, attribute index, block binding or draw instances
+    GLuint       object;
+    std::int64_t size;
+};
+
+struct DeviceCounters {
+    int          commands        = 0;
+    int          bufferCreates   = 0;
+    int          bufferUploads   = 0;   // bufferData + bufferSubData
+    std::int64_t uploadBytes     = 0;
+    int          bufferBinds     = 0;
+    int          vaoCreates      = 0;
+    int          vaoBinds        = 0;
+    int          programBinds    = 0;
+    int          uniformSets     = 0;
+    int          drawCalls       = 0;
+    std::int64_t indices         = 0;   // summed over instances
+    int          redundantBinds  = 0;   // buffer, VAO or program already bound
+};
+
+// Executes nothing: hands out object names, tracks bindings and appends every
+// call to a command stream with counters. Programs are stand-ins declared
+// with the uniforms they have, so Shader works on top of it unchanged.
+class RecordingDevice : public RenderDevice {
+public:
+    // A "linked" program with these uniforms at locations 0, 1, ...
+    GLuint addProgram(const std::vector<std::string>& uniforms);
+
+    // Forget the recorded stream and counters; names and bindings are kept,
+    // and so is the stream's capacity
+    void clear();
+
+    const std::vector<DeviceCommand>& commands() const { return stream; }
+    const DeviceCounters& counters() const { return counts; }
+
+    GLuint createBuffer() override;
+    void   deleteBuffer(GLuint buffer) override;
+    void   bindBuffer(GLenum target, GLuint buffer) override;
+    void   bufferData(GLenum target, GLsizeiptr bytes, const void* data, GLenum usage) override;
+    void   bufferSubData(GLenum target, GLintptr offset, GLsizeiptr bytes, const void* data) override;
+
+    GLuint createVertexArray() override;
+    void   deleteVertexArray(GLuint vao) override;
+    void   bindVertexArray(GLuint vao) override;
+    void   vertexAttribute(GLuint index, GLint size, GLsizei stride, std::size_t offset) override;
+
+    void  useProgram(GLuint program) override;
+    void  deleteProgram(GLuint program) override;
+    void  activeUniforms(GLuint program, std::vector<std::pair<std::string, GLint>>& out) override;
+    GLint uniformLocation(GLuint program, const char* name) override;
+    void  uniformBlockBinding(GLuint program, const char* block, GLuint binding) override;
+    void  programUniform1i(GLuint program, GLint location, GLint value) override;
+
+    void uniformMatrix4(GLint location, const float* value) override;
+    void uniformMatrix3(GLint location, const float* value) override;
+    void uniform3(GLint location, const float* value) override;
+    void uniform1f(GLint location, float value) override;
+    void uniform1i(GLint location, GLint value) override;
+
+    void drawElements(GLenum mode, GLsizei count, GLuint firstIndex, GLint baseVertex) override;
+    void drawElementsInstanced(GLenum mode, GLsizei count, GLuint firstIndex,
+                               GLsizei instances, GLint baseVertex) override;
+
+private:
+    std::vector<DeviceCommand> stream;
+    DeviceCounters             counts;
+
+    GLuint nextName = 1;   // shared by buffers, VAOs and programs
+    std::vector<std::pair<GLuint, std::vector<std::string>>> programs;
+
+    // Current bindings
+    std::vector<std::pair<GLenum, GLuint>> buffers;   // by target
+    GLuint vao     = 0;
+    GLuint program = 0;
+
+    void record(DeviceOp op, GLenum target, GLuint object, std::int64_t size);
+    GLuint& boundBuffer(GLenum target);
+    const std::vector<std::string>* uniformsOf(GLuint program) const;
+};
+
+// Device the draw path calls (a GlDevice unless replaced)
+RenderDevice& renderDevice();
+
+// Route the draw path through another device; nullptr restores the GL one
+void setRenderDevice(RenderDevice* device);
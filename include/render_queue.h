@@ -0,0 +1,87 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Shader.h"
+#include "mesh_registry.h"
+#include "frame_arena.h"
+#include "indirect_renderer.h"
+
+// State changes of the last flush, and what the same packets would have
+// cost drawn in the order they were submitted
+struct RenderStats {
+    int packets   = 0;
+    int drawCalls = 0;   // glDraw* calls issued (one per packet unless multi-draw is on)
+
+    int programChanges  = 0;
+    int vaoChanges      = 0;
+    int materialChanges = 0;
+
+    int unsortedProgramChanges  = 0;
+    int unsortedVaoChanges      = 0;
+    int unsortedMaterialChanges = 0;
+};
+
+// Collects the frame's non-instanced draws, sorts them by a 64-bit key
+// (program | VAO | material | depth) and issues them with as few
+// program binds, VAO binds and colour uploads as possible
+class RenderQueue {
+public:
+    // Start recording; packets live in the arena until it is reset
+    void begin(FrameArena& arena, const glm::mat4& viewMatrix);
+
+    // Record one draw of a mesh with a base colour and model matrix
+    void submit(Shader& shader, const Mesh& mesh, const glm::vec3& color, const glm::mat4& model);
+
+    // Sort and draw everything recorded since begin()
+    void flush();
+
+    // Submit every flush through one multi-draw with the given program when
+    // the renderer is available; pass nullptr to go back to per-packet draws
+    void useIndirect(IndirectRenderer* renderer, Shader* program);
+    bool indirect() const { return multiDraw && multiDraw->available(); }
+
+    const RenderStats& stats() const { return counters; }
+
+private:
+    struct Packet {
+        const Mesh* mesh;
+        glm::mat4   model;
+        int         program;
+        int         material;
+    };
+    struct Entry {
+        std::uint64_t key;
+        const Packet* packet;
+    };
+    // Programs seen so far with their per-draw uniforms, looked up at the
+    // shader's generation (a fallback may lack some the real program has)
+    struct Program {
+        Shader*       shader;
+        unsigned int  generation;
+        UniformHandle modelView, normalMatrix, baseColor;
+
+        void lookUp();
+    };
+
+    std::vector<Program>   programs;        // kept for the queue's lifetime
+    std::vector<glm::vec3> materials;       // this frame's base colours by material id
+    std::vector<int>       materialSlots;   // hash table of material id + 1 (0 = empty)
+    std::vector<Entry>     entries;         // capacities are kept between frames
+
+    IndirectRenderer* multiDraw      = nullptr;
+    Shader*           multiDrawShader = nullptr;
+
+    FrameArena* arena = nullptr;
+    glm::mat4   view  = glm::mat4(1.0f);
+    RenderStats counters;
+
+    // Last state in submission order, for the unsorted counters
+    int lastProgram = -1, lastMaterial = -1;
+    GLuint lastVao = 0;
+
+    int  programIndex(Shader& shader);
+    int  materialIndex(const glm::vec3& color);
+    void growMaterialSlots();
+};
@@ -1,15 +1,41 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <vector>
 #include "Shader.h"
+#include "mesh_registry.h"
+#include "skeleton.h"
+#include "culling.h"
+#include "clustered_lights.h"
+#include "lod.h"
+#include "render_queue.h"
+
+// Animation state of one robot (plain data, cheap to copy between threads)
+struct RobotState {
+    glm::vec3 position        = glm::vec3(0.0f);
+    float     baseRotationDeg = 0.0f;
+    float     rightArmDeg     = 0.0f;
+    float     headYawDeg      = 0.0f;
+    float     leftLegDeg      = 0.0f;
+    float     rightLegDeg     = 0.0f;
+};
+
+// Blend two robot states (t = 0 gives a, t = 1 gives b)
+RobotState lerp(const RobotState& a, const RobotState& b, float t);
 
 class Robot {
 public:
     Robot();
 
-    // GPU buffer management
+    // Build every mesh the robot can draw in the shared registry
     void initGPU();
-    void destroyGPU();
+
+    // Whole animation state
+    const RobotState& getState() const { return state; }
+    void setState(const RobotState& s) { state = s; poseDirty = true; }
+
+    // Placement on the ground plane
+    void setPosition(const glm::vec3& pos);
 
     // Animation control
     void setBaseRotation(float deg);
@@ -22,21 +48,42 @@ public:
     // Leg animation
     void animateLegs(float tSeconds);
 
-    // Draw the robot
-    void draw(Shader& shader);
+    // Store joint angles and root position as robot `index` of a pose
+    void writePose(SkeletonPose& pose, int index) const;
+
+    // Append the eye LEDs, just in front of each eye in the current pose
+    void addEyeLights(std::vector<PointLight>& out);
+
+    // Queue the parts of the robot inside the frustum, curved parts at the
+    // tessellation level their screen size calls for. The pose is solved
+    // once per state change, shared with addEyeLights.
+    void draw(RenderQueue& queue, Shader& shader, const Frustum& frustum,
+              const LodView& lod = LodView());
+
+    // Culling counters (parts) of the last draw
+    const CullStats& cullStats() const { return stats; }
+    // Parts and triangles per LOD level of the last draw
+    const LodStats& lodStats() const { return lodCounts; }
 
 private:
-    // Cube geometry (reused for all parts)
-    unsigned int cubeVAO, cubeVBO;
-
-    // Joint rotation angles
-    float baseRotationDeg;
-    float rightArmDeg;
-    float headYawDeg;
-    float leftLegDeg;
-    float rightLegDeg;
-
-    // Draw one part of the robot (a cube)
-    void drawCube(Shader& shader, const glm::mat4& parent,
-                  const glm::vec3& scale, const glm::vec3& translate);
-};
\ No newline at end of file
+    // Position and joint rotation angles
+    RobotState state;
+
+    // Single-robot pose and part matrices, reused every frame
+    SkeletonPose           pose;
+    std::vector<glm::mat4> partWorld;
+    bool                   poseDirty = true;   // state changed since partWorld was solved
+
+    // World bounds of every part; the BVH root is the whole robot
+    std::vector<AABB> partBounds;
+    Bvh               partBvh;
+    std::vector<int>  visibleParts;
+    CullStats         stats;
+
+    // Solve partWorld for the current state unless it is up to date
+    void solvePose();
+
+    // Current LOD level of every part (-1 until first drawn)
+    std::vector<int> partLod;
+    LodStats         lodCounts;
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "robot.h"
+#include "mesh_registry.h"
+#include "skeleton.h"
+#include "job_system.h"
+#include "culling.h"
+#include "lod.h"
+#include "stream_buffer.h"
+#include "instance_data.h"
+
+// Draws many robots with one instanced draw call per mesh type,
+// so the call count does not grow with the number of robots
+class RobotCrowd {
+public:
+    RobotCrowd();
+
+    // Lay out count robots on a square grid, each with its own pose and phase
+    void init(int count);
+
+    // GPU buffer management
+    void initGPU();
+    void destroyGPU();
+
+    // Animate every robot and solve its world matrices and bounds,
+    // spread over the job system in ranges of robots
+    void update(float tSeconds, JobSystem& jobs);
+
+    // Refit the robot BVH, cull it against the frustum, pick a LOD level per
+    // visible robot and pack instance data for the visible robots only
+    void cull(const Frustum& frustum, JobSystem& jobs, const LodView& lod = LodView());
+
+    // Stream instance data and draw; an INSTANCED mesh program must be in use
+    void draw();
+
+    int size() const;
+    // Draw calls issued by the last draw()
+    int drawCalls() const;
+    // Instance uploads that waited for the GPU to release their region
+    int uploadStalls() const { return instanceStream.stalls(); }
+    // Culling counters (robots) of the last cull()
+    const CullStats& cullStats() const { return stats; }
+    // Robots and triangles per LOD level of the last draw()
+    const LodStats& lodStats() const { return lodCounts; }
+
+private:
+    // All instances sharing one (mesh, tessellation) pair, used by robots at
+    // LOD levels [firstLevel, lastLevel]. Visible robots are grouped by level;
+    // the v-th robot of the batch's range writes its parts at
+    // instances[v * partsPerRobot + slot].
+    struct Batch {
+        Primitive mesh;
+        int       tessellation;
+        int       partsPerRobot;
+        int       firstLevel;
+        int       lastLevel;
+        GLuint    vao;
+        std::vector<InstanceData> instances;
+    };
+
+    std::vector<Robot> robots;   // animation state only; never initGPU'd
+    std::vector<float> phases;   // per-robot animation time offset
+
+    // Forward-kinematics input and output for all robots
+    SkeletonPose           pose;
+    std::vector<glm::mat4> partWorld;   // [robot][part]
+
+    std::vector<Batch> batches;
+    std::vector<int>   partBatch;       // [level][part] batch index
+    std::vector<int>   partSlot;        // [level][part] slot within the batch
+    int lastDrawCalls;
+
+    // Instance data of every batch, streamed each frame
+    StreamBuffer instanceStream;
+
+    // Per-robot world bounds and the hierarchy built over them
+    std::vector<AABB> robotBounds;
+    Bvh               bvh;
+    std::vector<int>  visible;          // robots that passed the last cull
+    CullStats         stats;
+
+    // Level selection: a robot is refined by its largest curved part
+    float             curvedDiameter;
+    std::vector<int>  robotLod;         // current level per robot (-1 = none yet)
+    std::vector<int>  ordered;          // visible robots grouped by level
+    int               levelStart[kLodLevels + 1];
+    long long         levelTriangles[kLodLevels];   // triangles of one robot per level
+    LodStats          lodCounts;
+
+    // Animate, solve and bound robots [begin, end)
+    void updateRange(float tSeconds, int begin, int end);
+    // Fill instances for ordered robots [begin, end)
+    void writeInstances(int begin, int end);
+};
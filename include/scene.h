@@ -1,7 +1,15 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <memory_resource>
+#include <vector>
 #include "Shader.h"
+#include "clustered_lights.h"
+#include "culling.h"
+#include "mesh_registry.h"
+#include "render_queue.h"
+#include "star_field.h"
+#include "vegetation.h"
 
 class Scene {
 public:
@@ -13,27 +21,70 @@ public:
     // Set scene: 1=default, 2=space, 3=jungle
     void setScene(int s);
 
-    // Draw active scene
-    void draw(Shader& shader);
+    // Free the star field's and the vegetation's GPU objects
+    void destroyGPU();
+
+    // Queue the parts of the active scene inside the frustum
+    void draw(RenderQueue& queue, Shader& shader, const Frustum& frustum);
+
+    // Draw the star field if the last draw() found it visible
+    void drawStars(Shader& starShader, float tSeconds);
+
+    // Stream and draw the jungle around eye (jungle scene only);
+    // instancedShader is an INSTANCED permutation of the mesh program and
+    // scratch holds the frame's transient lists
+    void drawVegetation(Shader& instancedShader, const glm::vec3& eye, const Frustum& frustum,
+                        std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+    Vegetation&       vegetation() { return jungle; }
+    const Vegetation& vegetation() const { return jungle; }
+
+    // Stars in the space scene
+    void setStarCount(int count) { stars.setCount(count); }
+    int  starCount() const { return stars.count(); }
+
+    // Point lights of the active scene at time t: the platform beacon, then
+    // drifting fireflies. count < 0 restores the scene's own number.
+    void gatherLights(float tSeconds, std::vector<PointLight>& out) const;
+    void setLightCount(int count) { lightOverride = count; }
+    int  lightCount() const;
+
+    // Culling counters of the last draw
+    const CullStats& cullStats() const { return stats; }
 
     // Get background color for current scene
     glm::vec3 clearColor() const;
 
 private:
+    // One draw of the ground quad or the star field
+    enum Geometry { GROUND, STARS };
+    struct Item {
+        Geometry  geometry;
+        glm::mat4 model;
+        glm::vec3 color;
+    };
+
     int currentScene;
 
+    // Drawables of the active scene in draw order, with their BVH
+    std::vector<Item> items;
+    bool              built;
+    Bvh               bvh;
+    std::vector<int>  visible;
+    CullStats         stats;
+
     // Ground geometry (reused)
-    unsigned int groundVAO;
-    unsigned int groundVBO;
+    Mesh groundMesh;
+
+    // Attribute-less star field (for space scene)
+    StarField stars;
+    bool      starsVisible;
 
-    // Stars geometry (for space scene)
-    unsigned int starVAO;
-    unsigned int starVBO;
-    int          starCount;
+    // Chunked jungle ground and plants (jungle scene)
+    Vegetation jungle;
 
-    void ensureStars();
+    // Lights forced by setLightCount (-1: scene default)
+    int lightOverride;
 
-    void drawGroundScene(Shader& shader);
-    void drawSpaceScene(Shader& shader);
-    void drawJungleScene(Shader& shader);
+    // Rebuild items and BVH for the current scene
+    void buildItems();
 };
\ No newline at end of file
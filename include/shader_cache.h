@@ -0,0 +1,57 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Everything a linked program depends on
+struct ProgramSource {
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string defines;   // "#define NAME VALUE" lines injected after #version
+};
+
+struct ShaderCacheStats {
+    int    hits     = 0;     // programs loaded from a cached binary
+    int    misses   = 0;     // programs compiled from source
+    int    rejected = 0;     // cached binaries the driver refused (deleted)
+    double loadMs    = 0.0;  // time spent loading binaries
+    double compileMs = 0.0;  // time spent compiling and linking
+};
+
+// Links programs from source and keeps their driver binaries on disk
+// (glGetProgramBinary / glProgramBinary). A binary is keyed by a hash of
+// both sources, the defines and the driver's vendor/renderer/version
+// strings, so editing a shader or updating the driver simply misses; a
+// binary the driver still refuses is deleted and rebuilt.
+class ShaderCache {
+public:
+    explicit ShaderCache(std::string directory = "shader_cache");
+
+    // Turn the disk cache off (every build compiles)
+    void setEnabled(bool on) { enabled = on; }
+
+    // Link a program, from the cache when possible; 0 on failure.
+    // Needs a current context; may be called from any thread that has one.
+    GLuint build(const ProgramSource& source);
+
+    // Delete every cached binary
+    void clear();
+
+    const std::string& directory() const { return dir; }
+    ShaderCacheStats stats() const;
+
+    // Source with the defines inserted after its #version line
+    static std::string injectDefines(const std::string& code, const std::string& defines);
+
+private:
+    std::string dir;
+    bool        enabled;
+
+    mutable std::mutex statsMutex;
+    ShaderCacheStats   counters;
+
+    std::string path(std::uint64_t key) const;
+    GLuint load(std::uint64_t key);
+    void   store(GLuint program, std::uint64_t key);
+};
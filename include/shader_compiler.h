@@ -0,0 +1,63 @@
+#pragma once
+#include <glad/glad.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Shader.h"
+#include "shader_cache.h"
+
+struct GLFWwindow;
+
+// Builds programs on a worker thread that owns a second, hidden context
+// sharing objects with the main one. Requested Shaders keep drawing with
+// whatever program they hold (a cheap fallback) until poll() swaps in the
+// finished one, so the render loop starts before the real programs exist.
+class ShaderCompiler {
+public:
+    ShaderCompiler();
+    ~ShaderCompiler();
+
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+    // Start the worker on sharedContext (a hidden window created with the main
+    // window as its share). Without one, requests are built on the spot.
+    void start(GLFWwindow* sharedContext, ShaderCache& cache);
+    void stop();
+
+    // Build source for target; target keeps its current program until poll()
+    void request(Shader& target, const ProgramSource& source);
+
+    // Main thread: hand finished programs to their Shaders; returns how many
+    int poll();
+
+    // Block until every request has been built (poll() still has to adopt them)
+    void waitIdle();
+
+    // Requests not yet adopted
+    int pending() const { return outstanding; }
+
+private:
+    struct Job {
+        Shader*       target;
+        ProgramSource source;
+        GLuint        program;
+    };
+
+    GLFWwindow*  context;
+    ShaderCache* cache;
+    std::thread  worker;
+    int          outstanding;
+
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Job>         queue;
+    std::vector<Job>        finished;
+    bool                    busy;
+    bool                    quit;
+
+    void workerLoop();
+};
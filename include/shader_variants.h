@@ -0,0 +1,63 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Shader.h"
+#include "shader_cache.h"
+#include "shader_compiler.h"
+
+// Feature bits of a program permutation; the point-light count is packed
+// into bits 8..11 of the key by shaderKey()
+enum ShaderFeature : std::uint32_t {
+    SHADER_LIGHTING  = 1u << 0,   // directional + point lights in the fragment stage
+    SHADER_INSTANCED = 1u << 1,   // per-instance model/normal/colour attributes
+    SHADER_UNLIT     = 1u << 2,   // flat base colour, no lighting math
+    SHADER_CLUSTERED = 1u << 3,   // point lights from the froxel light lists
+    SHADER_VERTEX_INVERSE = 1u << 4   // old per-vertex normal matrix (uModel), for --bench
+};
+
+// Key of one permutation: feature bits plus NUM_POINT_LIGHTS
+std::uint32_t shaderKey(std::uint32_t features, int pointLights = 0);
+
+// "#define" lines of a key, injected after #version
+std::string shaderDefines(std::uint32_t key);
+
+// Every permutation of one vertex/fragment pair, compiled on first use and
+// kept by key. With a compiler, a new permutation first draws with its UNLIT
+// sibling (built on the spot) while the real one is built in the background.
+class ShaderVariants {
+public:
+    // Without a compiler every permutation is built synchronously
+    ShaderVariants(std::string vertexPath, std::string fragmentPath,
+                   ShaderCache& cache, ShaderCompiler* compiler = nullptr);
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Uniform blocks and sampler units set in every permutation
+    void bindUniformBlock(const char* block, GLuint binding);
+    void bindSampler(const char* sampler, GLint unit);
+
+    // The program for a key, compiled (or requested) on first use
+    Shader& get(std::uint32_t key);
+
+    // Source of a permutation, for prebuilding or benchmarks
+    ProgramSource source(std::uint32_t key) const;
+
+    int count() const { return (int)variants.size(); }
+
+    // Delete every program (after the compiler has stopped)
+    void destroy();
+
+private:
+    std::string vertexPath, fragmentPath;
+    ShaderCache&    cache;
+    ShaderCompiler* compiler;
+    std::vector<std::pair<std::string, GLuint>> blocks;
+    std::vector<std::pair<std::string, GLint>>  samplers;
+    std::unordered_map<std::uint32_t, std::unique_ptr<Shader>> variants;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "camera.h"
+#include "robot.h"
+#include "triple_buffer.h"
+
+class InputRecorder;
+
+// Input sampled on the main thread (GLFW events must be polled there)
+struct InputState {
+    bool  forward  = false;
+    bool  backward = false;
+    bool  left     = false;
+    bool  right    = false;
+    bool  armUp    = false;
+    bool  armDown  = false;
+    int   scene      = 0;   // 1..3 requested, 0 = no change
+    int   cameraMode = 0;   // 1 = free, 2 = orbit, 0 = no change
+    float mouseDX  = 0.0f;  // accumulated since last consumed
+    float mouseDY  = 0.0f;
+};
+
+// Everything the renderer needs from the simulation
+struct SimState {
+    std::uint64_t tick = 0;
+    double     time = 0.0;      // simulation seconds
+    Camera     camera;
+    RobotState robot;
+    int        scene      = 1;
+    int        cameraMode = 1;
+};
+
+// Advance state by one fixed step of dt seconds (pure; same input, same result)
+void stepSimulation(SimState& state, const InputState& input, float dt);
+
+// Interpolated state for rendering between two steps
+SimState interpolate(const SimState& a, const SimState& b, float alpha);
+
+// Runs stepSimulation at a fixed rate on its own thread and publishes
+// snapshots through a lock-free triple buffer
+class Simulation {
+public:
+    explicit Simulation(double hz = 120.0);
+    ~Simulation();
+
+    void start(const SimState& initial);
+    void stop();
+
+    // Steps per second
+    double rate() const { return 1.0 / dt; }
+
+    // Log the input of every step from start() on (set before start; null = off)
+    void setRecorder(InputRecorder* log) { recorder = log; }
+
+    // Main thread: latest key state; mouse deltas accumulate until consumed
+    void submitInput(const InputState& input);
+
+    // Render thread: state interpolated for the current wall-clock time
+    SimState sample();
+
+private:
+    // Two consecutive steps, published together so the renderer can
+    // interpolate even if it missed intermediate snapshots
+    struct Snapshot {
+        SimState previous;
+        SimState current;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    const double         dt;
+    Clock::time_point    startTime;
+    std::thread          thread;
+    std::atomic<bool>    running;
+    InputRecorder*       recorder;
+
+    std::mutex           inputMutex;
+    InputState           pendingInput;
+
+    TripleBuffer<Snapshot> snapshots;
+    Snapshot               latest;   // render side
+
+    void run(SimState state);
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "mesh_registry.h"
+
+// Joints of the robot rig; parents always come before their children
+enum RobotJoint {
+    JOINT_ROOT,          // world position + base yaw
+    JOINT_TORSO,
+    JOINT_HEAD,          // head yaw
+    JOINT_R_SHOULDER,
+    JOINT_R_ARM,         // right arm raise
+    JOINT_L_SHOULDER,
+    JOINT_R_LEG,         // leg swing
+    JOINT_L_LEG,
+    JOINT_COUNT
+};
+
+// Static joint hierarchy plus the mesh parts attached to each joint.
+// A joint's local transform is translate(offset) * rotate(axis, angle).
+struct Skeleton {
+    std::vector<int>       parent;   // -1 for the root
+    std::vector<glm::vec3> offset;
+    std::vector<glm::vec3> axis;     // zero vector = joint does not rotate
+
+    // Parts: world = jointWorld[partJoint] * partLocal
+    std::vector<int>       partJoint;
+    std::vector<glm::mat4> partLocal;
+    std::vector<Primitive> partMesh;
+    std::vector<int>       partTessellation;
+    std::vector<glm::vec3> partColor;
+
+    // Tube part of each eye (the eyes carry LED point lights)
+    std::vector<int>       eyeParts;
+
+    int jointCount() const { return (int)parent.size(); }
+    int partCount() const { return (int)partJoint.size(); }
+};
+
+// The robot rig (built once)
+const Skeleton& robotSkeleton();
+
+// Joint angles and root positions for many robots, structure-of-arrays.
+// Storage is padded to a multiple of 4 robots for the SIMD solver.
+class SkeletonPose {
+public:
+    void resize(const Skeleton& skeleton, int count);
+
+    int size() const { return count; }
+    int paddedSize() const { return padded; }
+
+    // Angle (radians) of one joint for every robot
+    float*       angles(int joint)       { return &angle[joint * padded]; }
+    const float* angles(int joint) const { return &angle[joint * padded]; }
+
+    // Root position of every robot
+    float* rootX() { return rootPos[0].data(); }
+    float* rootY() { return rootPos[1].data(); }
+    float* rootZ() { return rootPos[2].data(); }
+    const float* rootX() const { return rootPos[0].data(); }
+    const float* rootY() const { return rootPos[1].data(); }
+    const float* rootZ() const { return rootPos[2].data(); }
+
+private:
+    int count  = 0;
+    int padded = 0;
+    std::vector<float> angle;        // [joint][robot]
+    std::vector<float> rootPos[3];   // [axis][robot]
+};
+
+// Forward kinematics for robots [begin, end): writes the world matrix of
+// every part to partWorld[robot * partCount + part]. begin must be a multiple
+// of 4; partWorld must hold pose.paddedSize() * partCount matrices.
+void solveForwardKinematics(const Skeleton& skeleton, const SkeletonPose& pose,
+                            int begin, int end, glm::mat4* partWorld);
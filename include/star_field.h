@@ -0,0 +1,31 @@
+#pragma once
+#include <glad/glad.h>
+#include "Shader.h"
+#include "culling.h"
+
+// Procedural star field drawn without vertex data: the star shader derives
+// each star's position, size, colour and twinkle from a hash of gl_VertexID.
+// GPU memory and startup cost are the same for 100 stars or 10 million.
+class StarField {
+public:
+    StarField();
+
+    // The empty VAO core profile needs for attribute-less draws
+    void initGPU();
+    void destroyGPU();
+
+    // Number of stars drawn (the density of the shell)
+    void setCount(int stars);
+    int  count() const { return stars; }
+
+    // World bounds of the shell the stars are scattered in
+    AABB bounds() const;
+
+    // Draw every star with the star program; tSeconds drives the twinkle
+    void draw(Shader& shader, float tSeconds);
+
+private:
+    GLuint vao;
+    int    stars;
+    float  innerRadius, outerRadius;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <glad/glad.h>
+
+// Ring buffer for data rewritten every frame (instance matrices, particles).
+// The buffer is split into kStreamRegions frame regions; the CPU fills one
+// while the GPU may still read the others, and a fence on each region keeps
+// it from being overwritten before the GPU is done with it.
+//
+// With GL 4.4 / ARB_buffer_storage the storage is mapped once, persistent and
+// coherent, and writes are plain memcpys. Otherwise the buffer is orphaned at
+// the start of each frame and filled with glBufferSubData.
+static const int kStreamRegions = 3;
+
+class StreamBuffer {
+public:
+    StreamBuffer();
+
+    // Load glBufferStorage; false if the context cannot map persistently.
+    // Call once after the GL loader; until then every buffer uses the fallback.
+    static bool loadEntryPoints(GLADloadproc load);
+    static bool persistentAvailable();
+
+    // Create the buffer with room for regionBytes per frame.
+    // persistent = false forces the orphan + glBufferSubData path.
+    void init(GLenum target, GLsizeiptr regionBytes, bool persistent = true);
+    void destroy();
+
+    // Copy bytes into this frame's region; returns their offset in buffer().
+    // A write that does not fit grows the buffer, which changes buffer().
+    GLintptr write(const void* data, GLsizeiptr bytes, GLsizeiptr align = 16);
+
+    // Fence the frame's region after the draws that read it and move on
+    void endFrame();
+
+    GLuint buffer() const { return name; }
+    bool   persistent() const { return mapped != nullptr; }
+
+    // Times a write had to wait for the GPU to release its region
+    int stalls() const { return waits; }
+
+private:
+    GLenum     target;
+    GLuint     name;
+    GLsizeiptr regionSize;
+    bool       wantPersistent;
+    char*      mapped;                  // whole buffer, persistent path only
+    GLsync     fences[kStreamRegions];
+    int        region;                  // region being filled
+    GLsizeiptr head;                    // bytes used in it
+    bool       frameStarted;
+    int        waits;
+
+    void create(GLsizeiptr regionBytes);
+    void release();
+    void beginFrame();
+};
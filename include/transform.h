@@ -0,0 +1,16 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+// Per-draw transforms computed once on the CPU instead of per vertex
+struct DrawTransform {
+    glm::mat4 modelView;
+    glm::mat3 normal;      // inverse-transpose of the model-view 3x3
+};
+
+inline DrawTransform makeDrawTransform(const glm::mat4& view, const glm::mat4& model) {
+    DrawTransform t;
+    t.modelView = view * model;
+    t.normal    = glm::inverseTranspose(glm::mat3(t.modelView));
+    return t;
+}
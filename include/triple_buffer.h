@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+
+// Lock-free single-producer/single-consumer triple buffer.
+// The writer fills writeBuffer() and publishes it; the reader always gets the
+// most recent published value and never blocks or tears.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& writeBuffer() { return buffers[back]; }
+    void publish() {
+        int old = middle.exchange(back | kFresh, std::memory_order_acq_rel);
+        back = old & kIndex;
+    }
+
+    // Reader side: take the newest value if one was published since last time
+    bool acquire() {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) return false;
+        int old = middle.exchange(front, std::memory_order_acq_rel);
+        front = old & kIndex;
+        return true;
+    }
+    const T& readBuffer() const { return buffers[front]; }
+
+private:
+    static const int kIndex = 3;
+    static const int kFresh = 4;
+
+    T                buffers[3] = {};
+    int              back   = 0;   // writer only
+    std::atomic<int> middle{1};    // shared
+    int              front  = 2;   // reader only
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstring>
+
+// Uniform block binding points shared by every program
+enum UniformBinding : GLuint {
+    FRAME_BINDING    = 0,   // FrameBlock: camera + lights, updated once per frame
+    MATERIAL_BINDING = 1,   // MaterialBlock: surface constants
+    CLUSTER_BINDING  = 2    // ClusterBlock: froxel grid of the clustered lights
+};
+
+// Point lights FrameBlock has room for (the shaders' array size)
+static const int kMaxPointLights = 4;
+
+// CPU mirror of the std140 FrameBlock declared in the shaders
+struct FrameConstants {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 dirLightDir;   float pad0;
+    glm::vec3 dirLightColor; float pad1;
+    glm::vec4 pointPos[kMaxPointLights];     // xyz, view space
+    glm::vec4 pointColor[kMaxPointLights];   // rgb
+};
+static_assert(sizeof(FrameConstants) == 288, "FrameConstants must match std140 FrameBlock");
+
+// CPU mirror of the std140 MaterialBlock declared in the fragment shader
+struct MaterialConstants {
+    glm::vec3 ambient;
+    float     shininess;
+};
+static_assert(sizeof(MaterialConstants) == 16, "MaterialConstants must match std140 MaterialBlock");
+
+// One std140 struct in a uniform buffer attached to a fixed binding point
+template <typename T>
+class UniformBuffer {
+public:
+    // Create the buffer and attach it to its binding point
+    void init(GLuint bindingPoint) {
+        if (ubo) return;
+        binding = bindingPoint;
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+    }
+
+    // Upload new contents; skipped when nothing changed
+    void update(const T& data) {
+        if (hasData && std::memcmp(&last, &data, sizeof(T)) == 0) return;
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        last = data;
+        hasData = true;
+    }
+
+    void destroy() {
+        if (ubo) glDeleteBuffers(1, &ubo);
+        ubo = 0;
+        hasData = false;
+    }
+
+private:
+    GLuint ubo     = 0;
+    GLuint binding = 0;
+    T      last{};
+    bool   hasData = false;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "culling.h"
+#include "instance_data.h"
+#include "mesh_registry.h"
+
+// World layout of the jungle
+struct VegetationSettings {
+    std::uint32_t seed           = 1337;
+    float         chunkSize      = 32.0f;      // world units per chunk side
+    int           viewChunks     = 3;          // chunks kept around the camera in each direction
+    int           plantsPerChunk = 2000;
+    std::size_t   memoryBudget   = 32u << 20;  // resident instance bytes before LRU eviction
+};
+
+// Counters since start (generation, eviction) and of the last draw
+struct VegetationStats {
+    int         residentChunks  = 0;
+    std::size_t residentBytes   = 0;
+    int         generatedChunks = 0;
+    int         evictedChunks   = 0;
+    double      generateMsTotal = 0.0;   // worker time spent generating
+    double      generateMsMax   = 0.0;
+    int         visibleChunks   = 0;
+    long long   instances       = 0;
+    int         drawCalls       = 0;
+};
+
+// Jungle ground and plants on an unbounded grid of square chunks. Chunks
+// around the camera are generated on a worker thread from a hash of
+// (seed, chunk x, chunk z), so revisiting a place rebuilds the same plants.
+// Finished chunks are uploaded once into their own instance buffer and kept
+// until the resident total exceeds the memory budget, least recently used
+// first. Everything is drawn with the INSTANCED mesh program.
+class Vegetation {
+public:
+    Vegetation();
+    ~Vegetation();
+
+    Vegetation(const Vegetation&) = delete;
+    Vegetation& operator=(const Vegetation&) = delete;
+
+    // Change the layout; drops every chunk
+    void configure(const VegetationSettings& settings);
+    const VegetationSettings& settings() const { return config; }
+
+    // Stop the worker and free every buffer
+    void destroyGPU();
+
+    // Request the chunks around eye (nearest first), upload the finished
+    // ones and evict over budget; the per-call chunk list lives in scratch
+    void update(const glm::vec3& eye, std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+    // Draw the resident chunks inside the frustum; the instanced program must be in use
+    void draw(const Frustum& frustum);
+
+    // Block until every requested chunk has been generated (next update uploads them)
+    void waitIdle();
+
+    const VegetationStats& stats() const { return counters; }
+
+    // Generate chunk (x, z) twice on this thread and compare the instances
+    static bool sameChunkTwice(const VegetationSettings& settings, int x, int z);
+
+private:
+    // Instance groups of a chunk, one instanced draw each
+    enum Kind { GROUND_TILE, BUSH, TRUNK, CANOPY, kKinds };
+
+    struct Chunk {
+        AABB          bounds;
+        GLuint        vbo;
+        GLintptr      offset[kKinds];
+        GLsizei       count[kKinds];
+        std::size_t   bytes;
+        std::uint64_t lastUsed;   // update() number
+    };
+    // Worker output, uploaded on the GL thread
+    struct Generated {
+        std::uint64_t             key;
+        AABB                      bounds;
+        std::vector<InstanceData> instances[kKinds];
+        double                    ms;
+    };
+
+    VegetationSettings config;
+    VegetationStats    counters;
+    std::uint64_t      frame;
+
+    GLuint vao;              // shared geometry + instance attributes
+    Mesh   meshes[kKinds];
+
+    std::unordered_map<std::uint64_t, Chunk> chunks;   // resident
+    std::unordered_set<std::uint64_t>        queued;   // requested, result not uploaded yet
+    std::vector<const Chunk*>                visible;
+
+    // Worker thread and its queues (guarded by mutex)
+    std::thread                worker;
+    std::mutex                 mutex;
+    std::condition_variable    wake;      // new requests or quit
+    std::condition_variable    idle;      // a request finished
+    std::deque<std::uint64_t>  requests;  // nearest first
+    std::vector<Generated>     done;
+    bool                       busy;
+    bool                       quit;
+
+    void initGPU();
+    void stopWorker();
+    void workerLoop();
+    void upload(Generated& g);
+    void evict();
+
+    static std::uint64_t key(int x, int z);
+    static Generated generate(const VegetationSettings& settings, std::uint64_t key);
+};
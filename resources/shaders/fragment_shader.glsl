@@ -1,47 +1,87 @@
 #version 330 core
+// Permutation defines (injected after #version):
+//   LIGHTING           directional light + NUM_POINT_LIGHTS point lights
+//   NUM_POINT_LIGHTS   0..4 point lights from FrameBlock (unrolled at compile time)
+//   CLUSTERED          point lights from this fragment's froxel (see ClusteredLights)
+//   UNLIT              flat base colour, no lighting math
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS 0
+#endif
+
 out vec4 FragColor;
 
 in vec3 vNormal;    // from VS (view space)
 in vec3 vPos;       // from VS (view space)
+in vec3 vColor;     // base color (diffuse), per draw or per instance
 
-// parameters
-uniform vec3 uBaseColor;      // robot/ground base color (diffuse)
-uniform bool uUseLight;
-
-// two lights
-uniform vec3 uDirLightDir;    // directional (view space)
-uniform vec3 uDirLightColor;
-uniform vec3 uPointPos;       // point light position (view space)
-uniform vec3 uPointColor;
+// per-frame constants: camera + lights (view space)
+layout (std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProj;
+    vec3 uDirLightDir;        // directional
+    vec3 uDirLightColor;
+    vec4 uPointPos[4];        // point light positions (xyz)
+    vec4 uPointColor[4];
+};
 
 // material
-uniform float uShininess;     // ~32..128
-uniform vec3  uAmbient;       // small ambient term
+layout (std140) uniform MaterialBlock {
+    vec3  uAmbient;           // small ambient term
+    float uShininess;         // ~32..128
+};
 
-void main() {
-    if (!uUseLight) {
-        FragColor = vec4(uBaseColor, 1.0);
-        return;
-    }
+#ifdef CLUSTERED
+// froxel grid layout for this view
+layout (std140) uniform ClusterBlock {
+    uvec4 uClusterDims;       // x, y, z slices, light count
+    vec4  uClusterParams;     // slice scale, slice bias, tile size in pixels
+};
+uniform samplerBuffer  uLightData;      // 2 texels per light: view pos + radius, color
+uniform usamplerBuffer uLightGrid;      // per cluster: first index, count
+uniform usamplerBuffer uLightIndices;
+#endif
 
+// Blinn-Phong diffuse and specular of one light direction
+void shade(vec3 N, vec3 V, vec3 L, vec3 lightColor, inout vec3 diffuse, inout vec3 specular) {
+    vec3 H = normalize(L + V);
+    diffuse  += vColor * lightColor * max(dot(N, L), 0.0);
+    specular += lightColor * pow(max(dot(N, H), 0.0), uShininess);
+}
+
+void main() {
+#if defined(UNLIT) || !defined(LIGHTING)
+    FragColor = vec4(vColor, 1.0);
+#else
     vec3 N = normalize(vNormal);
     vec3 V = normalize(-vPos);
 
     // Dir light
-    vec3 L0 = normalize(uDirLightDir);
-    vec3 H0 = normalize(L0 + V);
-    float diff0 = max(dot(N, L0), 0.0);
-    float spec0 = pow(max(dot(N, H0), 0.0), uShininess);
+    vec3 diffuse  = vec3(0.0);
+    vec3 specular = vec3(0.0);
+    shade(N, V, normalize(uDirLightDir), uDirLightColor, diffuse, specular);
 
-    // Point light
-    vec3 L1 = normalize(uPointPos - vPos);
-    vec3 H1 = normalize(L1 + V);
-    float diff1 = max(dot(N, L1), 0.0);
-    float spec1 = pow(max(dot(N, H1), 0.0), uShininess);
+    // Point lights
+#if NUM_POINT_LIGHTS > 0
+    for (int i = 0; i < NUM_POINT_LIGHTS; ++i)
+        shade(N, V, normalize(uPointPos[i].xyz - vPos), uPointColor[i].rgb, diffuse, specular);
+#endif
 
-    vec3 diffuse  = uBaseColor * (uDirLightColor * diff0 + uPointColor * diff1);
-    vec3 specular = vec3(1.0)   * (uDirLightColor * spec0 + uPointColor * spec1);
+#ifdef CLUSTERED
+    // Only the lights assigned to this fragment's froxel, faded out at their radius
+    int z = int(clamp(floor(log(-vPos.z) * uClusterParams.x + uClusterParams.y), 0.0, float(uClusterDims.z - 1u)));
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / uClusterParams.zw), ivec2(uClusterDims.xy) - 1);
+    uvec2 cell = texelFetch(uLightGrid, (z * int(uClusterDims.y) + tile.y) * int(uClusterDims.x) + tile.x).xy;
+    for (uint i = 0u; i < cell.y; ++i) {
+        int  light  = int(texelFetch(uLightIndices, int(cell.x + i)).r);
+        vec4 posR   = texelFetch(uLightData, light * 2);
+        vec3 color  = texelFetch(uLightData, light * 2 + 1).rgb;
+        vec3 toL    = posR.xyz - vPos;
+        float fade  = clamp(1.0 - dot(toL, toL) / (posR.w * posR.w), 0.0, 1.0);
+        shade(N, V, normalize(toL), color * fade * fade, diffuse, specular);
+    }
+#endif
 
     vec3 color = uAmbient + diffuse + specular;
     FragColor = vec4(color, 1.0);
-}
\ No newline at end of file
+#endif
+}
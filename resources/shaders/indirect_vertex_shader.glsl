@@ -0,0 +1,41 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 10) in uint aDrawId;   // per-draw index, advanced by the command's baseInstance
+
+// per-draw transforms and colour, one entry per multi-draw command
+struct DrawData {
+    mat4 modelView;
+    mat3 normalMatrix;   // std430: each column padded to a vec4
+    vec4 color;
+};
+layout (std430, binding = 0) readonly buffer DrawBlock {
+    DrawData uDraws[];
+};
+
+// per-frame constants (shared with the fragment shader)
+layout (std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProj;
+    vec3 uDirLightDir;
+    vec3 uDirLightColor;
+    vec4 uPointPos[4];     // xyz, view space
+    vec4 uPointColor[4];
+};
+
+out vec3 vNormal;   // normal in view space
+out vec3 vPos;      // position in view space
+out vec3 vColor;    // base color
+
+void main() {
+    DrawData d = uDraws[aDrawId];
+
+    vNormal   = normalize(d.normalMatrix * aNormal);
+
+    vec4 posV = d.modelView * vec4(aPos, 1.0);
+    vPos      = posV.xyz;
+
+    vColor    = d.color.rgb;
+
+    gl_Position = uProj * posV;
+}
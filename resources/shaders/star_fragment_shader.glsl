@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 vColor;   // brightness and tint of the star
+
+void main() {
+    // Round points, slightly dimmer towards the rim
+    vec2  d  = gl_PointCoord * 2.0 - 1.0;
+    float r2 = dot(d, d);
+    if (r2 > 1.0) discard;
+    FragColor = vec4(vColor * (1.0 - 0.5 * r2), 1.0);
+}
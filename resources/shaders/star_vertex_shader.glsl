@@ -0,0 +1,56 @@
+#version 330 core
+// No vertex attributes: every star is generated from gl_VertexID
+
+// per-frame constants (shared with the other programs)
+layout (std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProj;
+    vec3 uDirLightDir;
+    vec3 uDirLightColor;
+    vec4 uPointPos[4];     // xyz, view space
+    vec4 uPointColor[4];
+};
+
+uniform float uTime;          // seconds, drives the twinkle
+uniform float uInnerRadius;   // stars lie in the shell [inner, outer] around the origin
+uniform float uOuterRadius;
+
+out vec3 vColor;
+
+// Integer hash with good avalanche (lowbias32)
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Next uniform value in [0, 1) from a running hash state
+float random(inout uint state) {
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+void main() {
+    uint state = hash(uint(gl_VertexID) ^ 0x9e3779b9u);
+
+    // Uniform direction on the sphere, distance inside the shell
+    float z   = random(state) * 2.0 - 1.0;
+    float a   = random(state) * 6.2831853;
+    float r   = sqrt(1.0 - z * z);
+    vec3 dir  = vec3(r * cos(a), z, r * sin(a));
+    float dist = mix(uInnerRadius, uOuterRadius, random(state));
+
+    // Few bright stars, many faint ones; bright ones are drawn larger
+    float magnitude = pow(random(state), 3.0);
+    float phase     = random(state) * 6.2831853;
+    float speed     = mix(1.5, 5.0, random(state));
+    float twinkle   = 0.75 + 0.25 * sin(uTime * speed + phase);
+    vec3 tint       = mix(vec3(0.75, 0.85, 1.0), vec3(1.0, 0.9, 0.75), random(state));
+
+    vColor       = tint * mix(0.35, 1.0, magnitude) * twinkle;
+    gl_PointSize = mix(1.0, 3.5, magnitude);
+    gl_Position  = uProj * uView * vec4(dir * dist, 1.0);
+}
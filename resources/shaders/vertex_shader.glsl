@@ -1,21 +1,57 @@
 #version 330 core
+// Permutation defines (injected after #version): INSTANCED, VERTEX_INVERSE
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
+#ifdef INSTANCED
+// per-instance data (see InstanceData)
+layout (location = 2) in mat4 aModel;          // locations 2..5
+layout (location = 6) in mat3 aNormalMatrix;   // locations 6..8, world space
+layout (location = 9) in vec3 aColor;
+#else
+#ifdef VERTEX_INVERSE
+// the old path, kept to benchmark against: model matrix only, the normal
+// matrix is derived for every vertex
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProj;
+#else
+// per-draw transforms, computed on the CPU
+uniform mat4 uModelView;
+uniform mat3 uNormalMatrix;   // inverse-transpose of uModelView's 3x3
+#endif
+uniform vec3 uBaseColor;      // robot/ground base color (diffuse)
+#endif
+
+// per-frame constants (shared with the fragment shader)
+layout (std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProj;
+    vec3 uDirLightDir;
+    vec3 uDirLightColor;
+    vec4 uPointPos[4];     // xyz, view space
+    vec4 uPointColor[4];
+};
 
 out vec3 vNormal;   // normal in view space
 out vec3 vPos;      // position in view space
+out vec3 vColor;    // base color
 
 void main() {
+#ifdef INSTANCED
+    // view is rigid, so its 3x3 carries world normals into view space
+    vNormal   = normalize(mat3(uView) * (aNormalMatrix * aNormal));
+    vec4 posV = uView * aModel * vec4(aPos, 1.0);
+    vColor    = aColor;
+#elif defined(VERTEX_INVERSE)
     mat4 MV   = uView * uModel;
-    mat3 NMat = mat3(transpose(inverse(MV)));
-    vNormal   = normalize(NMat * aNormal);
-
+    vNormal   = normalize(mat3(transpose(inverse(MV))) * aNormal);
     vec4 posV = MV * vec4(aPos, 1.0);
+    vColor    = uBaseColor;
+#else
+    vNormal   = normalize(uNormalMatrix * aNormal);
+    vec4 posV = uModelView * vec4(aPos, 1.0);
+    vColor    = uBaseColor;
+#endif
     vPos      = posV.xyz;
 
     gl_Position = uProj * posV;
-}
\ No newline at end of file
+}
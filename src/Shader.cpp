@@ -1,65 +1,177 @@
 #include "Shader.h"
+#include "render_device.h"
 #include <glad/glad.h>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 // Constructor: load and compile shaders, then link the program
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    std::string vCode = readFile(vertexPath);
-    std::string fCode = readFile(fragmentPath);
-    const char* vSrc = vCode.c_str();
-    const char* fSrc = fCode.c_str();
+Shader::Shader(const char* vertexPath, const char* fragmentPath)
+    : ID(link(readFile(vertexPath), readFile(fragmentPath))) {
+    cacheUniforms();
+}
+
+Shader::Shader(unsigned int program) : ID(program) {
+    cacheUniforms();
+}
+
+// Compile both stages and link them
+unsigned int Shader::link(const std::string& vertexCode, const std::string& fragmentCode) {
+    const char* vSrc = vertexCode.c_str();
+    const char* fSrc = fragmentCode.c_str();
 
     // Compile vertex shader
     unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vs, 1, &vSrc, nullptr);
     glCompileShader(vs);
-    checkCompileErrors(vs, "VERTEX");
+    bool ok = checkCompileErrors(vs, "VERTEX");
 
     // Compile fragment shader
     unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fs, 1, &fSrc, nullptr);
     glCompileShader(fs);
-    checkCompileErrors(fs, "FRAGMENT");
+    ok = checkCompileErrors(fs, "FRAGMENT") && ok;
 
-    // Link shaders into program
-    ID = glCreateProgram();
-    glAttachShader(ID, vs);
-    glAttachShader(ID, fs);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+    // Link shaders into program; ask for a binary the cache can store (GL 4.1)
+    unsigned int program = glCreateProgram();
+    if (glProgramParameteri) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    ok = checkCompileErrors(program, "PROGRAM") && ok;
 
     // Delete shaders after linking
     glDeleteShader(vs);
     glDeleteShader(fs);
+
+    if (!ok) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
 }
 
 // Activate the shader program
-void Shader::use() const { glUseProgram(ID); }
+void Shader::use() const { renderDevice().useProgram(ID); }
+
+// Attach a uniform block to a binding point
+void Shader::bindUniformBlock(const char* block, unsigned int binding) {
+    renderDevice().uniformBlockBinding(ID, block, binding);
+
+    // Remembered for adopt()
+    for (auto& b : blockBindings)
+        if (b.first == block) { b.second = binding; return; }
+    blockBindings.emplace_back(block, binding);
+}
+
+// Set a sampler's texture unit without binding the program (GL 4.1)
+void Shader::bindSampler(const char* sampler, int unit) {
+    RenderDevice& device = renderDevice();
+    int loc = device.uniformLocation(ID, sampler);
+    if (loc >= 0) device.programUniform1i(ID, loc, unit);
+
+    // Remembered for adopt()
+    for (auto& s : samplerBindings)
+        if (s.first == sampler) { s.second = unit; return; }
+    samplerBindings.emplace_back(sampler, unit);
+}
+
+void Shader::adopt(unsigned int program) {
+    if (program == 0 || program == ID) return;
+    RenderDevice& device = renderDevice();
+    if (ID) device.deleteProgram(ID);
+    ID = program;
+    ++programGeneration;
+
+    // Existing handles keep their slots: point them at the new locations
+    // (-1 if the new program lacks the uniform) and forget cached values
+    for (const auto& entry : slotByName) {
+        slots[entry.second].location = device.uniformLocation(ID, entry.first.c_str());
+        slots[entry.second].hasValue = false;
+    }
+    cacheUniforms();
+
+    for (const auto& b : blockBindings)
+        device.uniformBlockBinding(ID, b.first.c_str(), b.second);
+    for (const auto& s : samplerBindings) {
+        int loc = device.uniformLocation(ID, s.first.c_str());
+        if (loc >= 0) device.programUniform1i(ID, loc, s.second);
+    }
+}
+
+// Read every active uniform after linking; names already known keep their slot
+void Shader::cacheUniforms() {
+    std::vector<std::pair<std::string, GLint>> active;
+    renderDevice().activeUniforms(ID, active);
+    for (const auto& entry : active) {
+        // Uniform block members have no location
+        int loc = entry.second;
+        if (loc < 0) continue;
+
+        // Arrays are reported as "name[0]"; register the bare name
+        std::string key = entry.first;
+        if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+            key.resize(key.size() - 3);
+        if (uniform(key.c_str()).valid()) continue;
+
+        UniformSlot slot = {loc, 0, false, {}};
+        slots.push_back(slot);
+        slotByName.emplace_back(key, (int)slots.size() - 1);
+        std::sort(slotByName.begin(), slotByName.end());
+    }
+}
+
+UniformHandle Shader::uniform(const char* name) const {
+    auto it = std::lower_bound(slotByName.begin(), slotByName.end(), name,
+        [](const std::pair<std::string, int>& e, const char* n) {
+            return std::strcmp(e.first.c_str(), n) < 0;
+        });
+    UniformHandle h;
+    if (it != slotByName.end() && it->first == name) h.slot = it->second;
+    return h;
+}
+
+bool Shader::unchanged(UniformHandle h, const void* data, int floats) const {
+    UniformSlot& s = slots[h.slot];
+    size_t bytes = floats * sizeof(float);
+    if (s.hasValue && s.size == floats && std::memcmp(s.value, data, bytes) == 0)
+        return true;
+    std::memcpy(s.value, data, bytes);
+    s.size = floats;
+    s.hasValue = true;
+    return false;
+}
 
 // Set Mat4 uniform
-void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    int loc = glGetUniformLocation(ID, name.c_str());
-    glUniformMatrix4fv(loc, 1, GL_FALSE, &mat[0][0]);
+void Shader::setMat4(UniformHandle h, const glm::mat4& mat) const {
+    if (!h.valid() || unchanged(h, &mat[0][0], 16)) return;
+    renderDevice().uniformMatrix4(slots[h.slot].location, &mat[0][0]);
+}
+
+// Set Mat3 uniform
+void Shader::setMat3(UniformHandle h, const glm::mat3& mat) const {
+    if (!h.valid() || unchanged(h, &mat[0][0], 9)) return;
+    renderDevice().uniformMatrix3(slots[h.slot].location, &mat[0][0]);
 }
 
 // Set Vec3 uniform
-void Shader::setVec3(const std::string& name, const glm::vec3& v) const {
-    int loc = glGetUniformLocation(ID, name.c_str());
-    glUniform3fv(loc, 1, &v[0]);
+void Shader::setVec3(UniformHandle h, const glm::vec3& v) const {
+    if (!h.valid() || unchanged(h, &v[0], 3)) return;
+    renderDevice().uniform3(slots[h.slot].location, &v[0]);
 }
 
 // Set Float uniform
-void Shader::setFloat(const std::string& name, float v) const {
-    int loc = glGetUniformLocation(ID, name.c_str());
-    glUniform1f(loc, v);
+void Shader::setFloat(UniformHandle h, float v) const {
+    if (!h.valid() || unchanged(h, &v, 1)) return;
+    renderDevice().uniform1f(slots[h.slot].location, v);
 }
 
 // Set Int uniform
-void Shader::setInt(const std::string& name, int v) const {
-    int loc = glGetUniformLocation(ID, name.c_str());
-    glUniform1i(loc, v);
+void Shader::setInt(UniformHandle h, int v) const {
+    if (!h.valid() || unchanged(h, &v, 1)) return;
+    renderDevice().uniform1i(slots[h.slot].location, v);
 }
 
 // Read shader source from file path
@@ -73,8 +185,8 @@ std::string Shader::readFile(const char* path) {
     return ss.str();
 }
 
-// Check for shader compile or link errors
-void Shader::checkCompileErrors(unsigned int obj, const std::string& type) {
+// Check for shader compile or link errors; false if there were any
+bool Shader::checkCompileErrors(unsigned int obj, const std::string& type) {
     int success; char log[1024];
     if (type != "PROGRAM") {
         glGetShaderiv(obj, GL_COMPILE_STATUS, &success);
@@ -89,4 +201,5 @@ void Shader::checkCompileErrors(unsigned int obj, const std::string& type) {
             std::cerr << "link error:\n" << log << "\n";
         }
     }
-}
\ No newline at end of file
+    return success != 0;
+}
@@ -0,0 +1,32 @@
+#include "alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+// Per thread: a frame only counts what the render thread itself allocated,
+// not the simulation, job or encoder threads running next to it
+static thread_local std::uint64_t tAllocations = 0;
+
+std::uint64_t threadAllocations() {
+    return tAllocations;
+}
+
+// The array and nothrow forms of the standard library call these two, so
+// replacing them counts every operator new in the program
+void* operator new(std::size_t bytes) {
+    ++tAllocations;
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t bytes, std::align_val_t align) {
+    ++tAllocations;
+    // aligned_alloc wants a multiple of the alignment
+    std::size_t a = (std::size_t)align;
+    if (void* p = std::aligned_alloc(a, bytes ? (bytes + a - 1) / a * a : a)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
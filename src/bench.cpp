@@ -0,0 +1,553 @@
+#include "bench.h"
+#include "skeleton.h"
+#include "robot_crowd.h"
+#include "job_system.h"
+#include "culling.h"
+#include "stream_buffer.h"
+#include "vegetation.h"
+#include "robot.h"
+#include "scene.h"
+#include "render_device.h"
+#include "render_queue.h"
+#include "frame_arena.h"
+#include "alloc_counter.h"
+#include "simulation.h"
+#include "mesh_registry.h"
+#include "transform.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+// Nearest-rank percentile of sorted samples: the smallest sample with at
+// least p% of the samples at or below it
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+TimingSummary summarize(std::vector<double> samples) {
+    TimingSummary s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    s.min  = samples.front();
+    s.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    s.p50  = percentile(samples, 50.0);
+    s.p95  = percentile(samples, 95.0);
+    s.p99  = percentile(samples, 99.0);
+    return s;
+}
+
+// ------------------------------------------------
+// OffscreenTarget
+// ------------------------------------------------
+OffscreenTarget::OffscreenTarget() : fbo(0), colorRBO(0), depthRBO(0) {}
+
+bool OffscreenTarget::init(int width, int height) {
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorRBO);
+    glGenRenderbuffers(1, &depthRBO);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!ok) std::cerr << "Offscreen framebuffer incomplete\n";
+    return ok;
+}
+
+void OffscreenTarget::destroy() {
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+    if (colorRBO) glDeleteRenderbuffers(1, &colorRBO);
+    if (depthRBO) glDeleteRenderbuffers(1, &depthRBO);
+    fbo = colorRBO = depthRBO = 0;
+}
+
+void OffscreenTarget::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, fbo); }
+
+// ------------------------------------------------
+// GpuTimer
+// ------------------------------------------------
+GpuTimer::GpuTimer() : queries{}, head(0), pending(0), ringStalls(0) {}
+
+void GpuTimer::init() {
+    if (!queries[0]) glGenQueries(kQueries, queries);
+    held.reserve(kQueries);
+}
+
+void GpuTimer::destroy() {
+    if (queries[0]) glDeleteQueries(kQueries, queries);
+    for (GLuint& q : queries) q = 0;
+    head = pending = ringStalls = 0;
+    held.clear();
+}
+
+void GpuTimer::begin() {
+    // Ring is full: the oldest result must be read before its query is
+    // reused; it is kept for the caller's next collect()
+    if (pending == kQueries) {
+        ++ringStalls;
+        read(held, true);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[head]);
+}
+
+void GpuTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    head = (head + 1) % kQueries;
+    ++pending;
+}
+
+void GpuTimer::collect(std::vector<double>& out, bool wait) {
+    out.insert(out.end(), held.begin(), held.end());
+    held.clear();
+    read(out, wait);
+}
+
+void GpuTimer::read(std::vector<double>& out, bool wait) {
+    while (pending > 0) {
+        GLuint q = queries[(head - pending + kQueries) % kQueries];
+        if (!wait) {
+            GLint ready = 0;
+            glGetQueryObjectiv(q, GL_QUERY_RESULT_AVAILABLE, &ready);
+            if (!ready) break;
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(q, GL_QUERY_RESULT, &ns);
+        out.push_back(ns / 1.0e6);
+        --pending;
+    }
+}
+
+// ------------------------------------------------
+// BenchReport
+// ------------------------------------------------
+void BenchReport::addCase(const std::string& name,
+                          const std::vector<double>& cpuMs,
+                          const std::vector<double>& gpuMs) {
+    cases.push_back({name, (int)cpuMs.size(), summarize(cpuMs), summarize(gpuMs)});
+}
+
+void BenchReport::addMetric(const std::string& name, double value) {
+    metrics.emplace_back(name, value);
+}
+
+static void writeSummary(std::ostream& os, const TimingSummary& s) {
+    os << "{\"min\": " << s.min << ", \"mean\": " << s.mean
+       << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+       << ", \"p99\": " << s.p99 << "}";
+}
+
+bool BenchReport::write(const std::string& path) const {
+    std::ofstream file;
+    if (!path.empty()) {
+        file.open(path);
+        if (!file) {
+            std::cerr << "Failed to open bench output: " << path << "\n";
+            return false;
+        }
+    }
+    std::ostream& os = path.empty() ? std::cout : file;
+
+    os << "{\n  \"cases\": [\n";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case& c = cases[i];
+        os << "    {\"name\": \"" << c.name << "\", \"frames\": " << c.frames
+           << ",\n     \"cpu_ms\": ";
+        writeSummary(os, c.cpu);
+        os << ",\n     \"gpu_ms\": ";
+        writeSummary(os, c.gpu);
+        os << "}" << (i + 1 < cases.size() ? "," : "") << "\n";
+    }
+    os << "  ],\n  \"metrics\": {";
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        os << (i ? ",\n" : "\n") << "    \"" << metrics[i].first << "\": " << metrics[i].second;
+    }
+    os << (metrics.empty() ? "" : "\n  ") << "}\n}\n";
+    return true;
+}
+
+// ------------------------------------------------
+// CPU microbenchmarks
+// ------------------------------------------------
+void benchForwardKinematics(BenchReport& report, int robots, int iterations) {
+    const Skeleton& skeleton = robotSkeleton();
+    SkeletonPose pose;
+    pose.resize(skeleton, robots);
+    for (int j = 0; j < skeleton.jointCount(); ++j)
+        for (int r = 0; r < robots; ++r)
+            pose.angles(j)[r] = 0.01f * (r + j);
+    std::vector<glm::mat4> partWorld(pose.paddedSize() * skeleton.partCount());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        solveForwardKinematics(skeleton, pose, 0, robots, partWorld.data());
+    auto stop = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration<double>(stop - start).count();
+    double matrices = (double)robots * skeleton.partCount() * iterations;
+    report.addMetric("fk_robots", robots);
+    report.addMetric("fk_ms_per_solve", sec * 1000.0 / iterations);
+    report.addMetric("fk_matrices_per_sec", sec > 0.0 ? matrices / sec : 0.0);
+}
+
+void benchJobScaling(BenchReport& report, int robots, int iterations) {
+    RobotCrowd crowd;
+    crowd.init(robots);
+
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double baseMs = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        JobSystem jobs(threads - 1);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            crowd.update(i / 60.0f, jobs);
+            crowd.cull(Frustum(), jobs);   // accepts everything: full instance build
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count() / iterations;
+        if (threads == 1) baseMs = ms;
+        std::string key = "crowd_update_" + std::to_string(threads) + "t";
+        report.addMetric(key + "_ms", ms);
+        report.addMetric(key + "_speedup", ms > 0.0 ? baseMs / ms : 0.0);
+    }
+}
+
+void benchCulling(BenchReport& report, int robots, int iterations) {
+    RobotCrowd crowd;
+    crowd.init(robots);
+    JobSystem jobs(0);
+    crowd.update(0.0f, jobs);
+
+    // Ground-level camera at one edge of the grid looking across it
+    float half = std::sqrt((float)robots) * 1.5f * 0.5f;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.6f, half + 2.0f), glm::vec3(0.0f, 0.9f, 0.0f),
+                                 glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    Frustum frustum(proj * view);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        crowd.cull(frustum, jobs);
+    auto stop = std::chrono::steady_clock::now();
+
+    const CullStats& stats = crowd.cullStats();
+    report.addMetric("cull_robots", robots);
+    report.addMetric("cull_ms", std::chrono::duration<double, std::milli>(stop - start).count() / iterations);
+    report.addMetric("cull_visible", stats.visible);
+    report.addMetric("cull_culled", stats.culled);
+    report.addMetric("cull_box_tests", stats.tests);
+}
+
+bool benchVegetationDeterminism(BenchReport& report) {
+    VegetationSettings settings;
+    const int chunks[][2] = {{0, 0}, {40, -120}, {-3000, 5000}, {1 << 24, -(1 << 24)}};
+    bool same = true;
+    for (const auto& c : chunks) {
+        if (Vegetation::sameChunkTwice(settings, c[0], c[1])) continue;
+        std::cerr << "benchVegetationDeterminism: chunk (" << c[0] << ", " << c[1] << ") differs between runs\n";
+        same = false;
+    }
+    report.addMetric("vegetation_deterministic", same ? 1 : 0);
+    return same;
+}
+
+// Per-frame bind budget of the submission benchmark: its robots and scenes
+// share one stand-in program and the registry's single VAO
+static const int kMaxProgramBinds = 1;
+static const int kMaxVaoBinds     = 2;
+
+bool benchSubmission(BenchReport& report, int robots, int frames) {
+    RecordingDevice device;
+    setRenderDevice(&device);
+    bool ownsGeometry = meshRegistry().vertexArray() == 0;
+
+    // Stand-in for the lit mesh program: the uniforms the queue sets per draw
+    Shader shader(device.addProgram({"uModelView", "uNormalMatrix", "uBaseColor"}));
+    Scene scene;
+    scene.ensureGround();
+    std::vector<Robot> crowd(robots);
+    int side = std::max(1, (int)std::ceil(std::sqrt((float)robots)));
+    for (int i = 0; i < robots; ++i) {
+        crowd[i].initGPU();
+        crowd[i].setPosition(glm::vec3((i % side - side / 2) * 1.5f, 0.0f, -(i / side) * 1.5f));
+    }
+    report.addMetric("submit_robots", robots);
+    report.addMetric("submit_setup_buffer_creates", device.counters().bufferCreates);
+    report.addMetric("submit_setup_upload_bytes", (double)device.counters().uploadBytes);
+
+    // Seen from behind the first row, like the orbit camera
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.5f, 6.0f), glm::vec3(0.0f, 0.9f, -side * 0.75f),
+                                 glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(proj * view);
+    LodView lod = makeLodView(view, proj, 720);
+
+    FrameMemory memory;
+    RenderQueue queue;
+    bool countsMatch = true;
+    const int warmup = 10;
+    for (int s = 1; s <= 3; ++s) {
+        scene.setScene(s);
+        SimState state;
+        std::vector<double> cpuMs;
+        cpuMs.reserve(frames);
+        std::uint64_t allocs = 0;
+        for (int i = 0; i < warmup + frames; ++i) {
+            stepSimulation(state, InputState(), 1.0f / 60.0f);
+            device.clear();
+
+            std::uint64_t allocsBefore = threadAllocations();
+            auto start = std::chrono::steady_clock::now();
+            memory.beginFrame();
+            queue.begin(memory.current(), view);
+            for (Robot& robot : crowd) {
+                RobotState rs = state.robot;
+                rs.position   = robot.getState().position;
+                robot.setState(rs);
+                robot.draw(queue, shader, frustum, lod);
+            }
+            scene.draw(queue, shader, frustum);
+            queue.flush();
+            auto stop = std::chrono::steady_clock::now();
+            if (i >= warmup) {
+                allocs += threadAllocations() - allocsBefore;
+                cpuMs.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+            }
+        }
+
+        // The device saw exactly what the queue says it issued
+        const DeviceCounters& dc = device.counters();
+        const RenderStats&    rs = queue.stats();
+        bool match = dc.drawCalls == rs.drawCalls && dc.programBinds == rs.programChanges &&
+                     dc.vaoBinds == rs.vaoChanges + 1;
+        if (!match) std::cerr << "benchSubmission: device calls differ from the queue's counters (scene " << s << ")\n";
+        // Per frame: no buffer work, one bind of the one program, and the
+        // registry VAO bound once plus the unbind at the end of the flush
+        bool bounded = dc.bufferCreates == 0 && dc.bufferUploads == 0 &&
+                       dc.programBinds <= kMaxProgramBinds && dc.vaoBinds <= kMaxVaoBinds;
+        if (!bounded)
+            std::cerr << "benchSubmission: scene " << s << " made " << dc.bufferCreates << " buffers, "
+                      << dc.bufferUploads << " uploads, " << dc.programBinds << " program binds (max "
+                      << kMaxProgramBinds << ") and " << dc.vaoBinds << " VAO binds (max " << kMaxVaoBinds << ")\n";
+        countsMatch = countsMatch && match && bounded;
+
+        std::string name = "submit_scene" + std::to_string(s);
+        report.addCase(name, cpuMs, std::vector<double>());
+        report.addMetric(name + "_commands", dc.commands);
+        report.addMetric(name + "_draw_calls", dc.drawCalls);
+        report.addMetric(name + "_program_binds", dc.programBinds);
+        report.addMetric(name + "_vao_binds", dc.vaoBinds);
+        report.addMetric(name + "_uniform_sets", dc.uniformSets);
+        report.addMetric(name + "_redundant_binds", dc.redundantBinds);
+        report.addMetric(name + "_indices", (double)dc.indices);
+        report.addMetric(name + "_allocs_per_frame", frames > 0 ? (double)allocs / frames : 0.0);
+    }
+    report.addMetric("submit_counts_match", countsMatch ? 1 : 0);
+
+    // Geometry named by the recording device means nothing to GL
+    if (ownsGeometry) meshRegistry().destroy();
+    setRenderDevice(nullptr);
+    return countsMatch;
+}
+
+// ------------------------------------------------
+// GL microbenchmarks
+// ------------------------------------------------
+void benchStreamUpload(BenchReport& report, GLuint program, int instances, int instanceBytes, int frames) {
+    const GLsizeiptr bytes = (GLsizeiptr)instances * instanceBytes;
+    std::vector<char> data((size_t)bytes);
+    // Several batches per frame, like the crowd's one upload per mesh type
+    const int kBatches = 4;
+    const GLsizeiptr batchBytes = bytes / kBatches;
+
+    // Each upload is followed by a point draw that sources it, so the
+    // driver has to keep the previous contents alive for the GPU
+    glUseProgram(program);
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(0);
+
+    report.addMetric("stream_instances", instances);
+    report.addMetric("stream_bytes_per_frame", (double)bytes);
+
+    const char* modes[3] = {"buffer_data", "orphan", "persistent"};
+    for (int mode = 0; mode < 3; ++mode) {
+        if (mode == 2 && !StreamBuffer::persistentAvailable()) {
+            report.addMetric("stream_persistent_available", 0);
+            continue;
+        }
+
+        GLuint vbo = 0;
+        StreamBuffer stream;
+        if (mode == 0) glGenBuffers(1, &vbo);
+        else stream.init(GL_ARRAY_BUFFER, bytes + kBatches * 16, mode == 2);
+
+        std::vector<double> cpuMs;
+        for (int f = 0; f < frames; ++f) {
+            auto start = std::chrono::steady_clock::now();
+            for (int b = 0; b < kBatches; ++b) {
+                const char* src = data.data() + b * batchBytes;
+                GLintptr offset = 0;
+                if (mode == 0) {
+                    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+                    glBufferData(GL_ARRAY_BUFFER, batchBytes, src, GL_STREAM_DRAW);
+                } else {
+                    offset = stream.write(src, batchBytes);
+                    glBindBuffer(GL_ARRAY_BUFFER, stream.buffer());
+                }
+                glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, instanceBytes, (void*)offset);
+                glDrawArrays(GL_POINTS, 0, 1);
+            }
+            if (mode != 0) stream.endFrame();
+            glFlush();
+            auto stop = std::chrono::steady_clock::now();
+            cpuMs.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+        glFinish();
+
+        TimingSummary t = summarize(cpuMs);
+        std::string key = std::string("stream_") + modes[mode];
+        report.addMetric(key + "_ms", t.mean);
+        report.addMetric(key + "_p99_ms", t.p99);
+        if (mode == 2) {
+            report.addMetric("stream_persistent_available", 1);
+            report.addMetric("stream_persistent_stalls", stream.stalls());
+        }
+
+        if (vbo) glDeleteBuffers(1, &vbo);
+        stream.destroy();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void benchVertexTransforms(BenchReport& report, Shader& perVertex, Shader& perDraw,
+                           const glm::mat4& view, int spheres, int frames) {
+    // Dense enough that each sphere covers a few pixels but many vertices
+    const Mesh& sphere = meshRegistry().get(Primitive::Sphere, 64);
+    const int side = std::max(1, (int)std::ceil(std::sqrt((double)spheres)));
+    std::vector<glm::mat4> models;
+    models.reserve(spheres);
+    for (int i = 0; i < spheres; ++i) {
+        glm::vec3 pos((i % side - side * 0.5f) * 0.12f, 1.0f + (i / side - side * 0.5f) * 0.12f, 0.0f);
+        models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), pos), glm::vec3(0.04f)));
+    }
+
+    GpuTimer gpuTimer;
+    gpuTimer.init();
+    const int warmup = 10;
+    const char* names[2] = {"vertex_inverse", "vertex_uniform"};
+    for (int path = 0; path < 2; ++path) {
+        Shader& shader = path == 0 ? perVertex : perDraw;
+        shader.use();
+        UniformHandle uModel        = shader.uniform("uModel");
+        UniformHandle uModelView    = shader.uniform("uModelView");
+        UniformHandle uNormalMatrix = shader.uniform("uNormalMatrix");
+        shader.setVec3("uBaseColor", glm::vec3(0.8f));
+
+        std::vector<double> cpuMs, gpuMs;
+        cpuMs.reserve(frames);
+        gpuMs.reserve(frames);
+        for (int f = 0; f < warmup + frames; ++f) {
+            bool measured = f >= warmup;
+            auto start = std::chrono::steady_clock::now();
+            if (measured) gpuTimer.begin();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            for (const glm::mat4& model : models) {
+                if (path == 0) {
+                    shader.setMat4(uModel, model);
+                } else {
+                    DrawTransform t = makeDrawTransform(view, model);
+                    shader.setMat4(uModelView, t.modelView);
+                    shader.setMat3(uNormalMatrix, t.normal);
+                }
+                MeshRegistry::draw(sphere);
+            }
+            if (measured) gpuTimer.end();
+            glFlush();
+            auto stop = std::chrono::steady_clock::now();
+            if (measured) {
+                cpuMs.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+                gpuTimer.collect(gpuMs);
+            }
+        }
+        gpuTimer.collect(gpuMs, true);
+        report.addCase(names[path], cpuMs, gpuMs);
+    }
+    gpuTimer.destroy();
+
+    report.addMetric("vertex_spheres", spheres);
+    report.addMetric("vertex_indices_per_frame", (double)sphere.count * spheres);
+}
+
+void benchVegetationStreaming(BenchReport& report, int frames) {
+    VegetationSettings settings;
+    settings.memoryBudget = 16u << 20;
+    Vegetation vegetation;
+    vegetation.configure(settings);
+
+    // Straight line at 2 units per frame: a new column of chunks every 16 frames
+    std::vector<double> cpuMs;
+    glm::vec3 eye(0.0f, 1.6f, 0.0f);
+    for (int i = 0; i < frames; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        vegetation.update(eye);
+        auto stop = std::chrono::steady_clock::now();
+        cpuMs.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+        eye.x += 2.0f;
+    }
+    vegetation.waitIdle();
+    vegetation.update(eye);
+
+    const VegetationStats& stats = vegetation.stats();
+    TimingSummary t = summarize(cpuMs);
+    report.addMetric("vegetation_stream_update_ms", t.mean);
+    report.addMetric("vegetation_stream_update_p99_ms", t.p99);
+    report.addMetric("vegetation_stream_chunks_generated", stats.generatedChunks);
+    report.addMetric("vegetation_stream_chunk_ms_mean",
+                     stats.generatedChunks ? stats.generateMsTotal / stats.generatedChunks : 0.0);
+    report.addMetric("vegetation_stream_evicted_chunks", stats.evictedChunks);
+    report.addMetric("vegetation_stream_resident_bytes", (double)stats.residentBytes);
+    report.addMetric("vegetation_stream_budget_bytes", (double)settings.memoryBudget);
+    vegetation.destroyGPU();
+}
+
+void benchShaderCache(BenchReport& report, const std::vector<ProgramSource>& programs) {
+    ShaderCache cache("shader_cache_bench");
+    cache.clear();
+
+    double ms[2] = {};
+    for (int pass = 0; pass < 2; ++pass) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<GLuint> built;
+        for (const ProgramSource& p : programs) built.push_back(cache.build(p));
+        glFinish();
+        ms[pass] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        for (GLuint program : built)
+            if (program) glDeleteProgram(program);
+    }
+
+    ShaderCacheStats stats = cache.stats();
+    report.addMetric("shader_programs", (double)programs.size());
+    report.addMetric("shader_cold_ms", ms[0]);
+    report.addMetric("shader_warm_ms", ms[1]);
+    report.addMetric("shader_warm_hits", stats.hits);
+    report.addMetric("shader_rejected", stats.rejected);
+    cache.clear();
+}
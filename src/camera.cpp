@@ -38,6 +38,16 @@ void Camera::processMouse(float xoffset, float yoffset) {
     updateCameraVectors();
 }
 
+// Blend two cameras for rendering between simulation steps
+Camera Camera::lerp(const Camera& a, const Camera& b, float t) {
+    Camera c = a;
+    c.Position = glm::mix(a.Position, b.Position, t);
+    c.Yaw      = glm::mix(a.Yaw, b.Yaw, t);
+    c.Pitch    = glm::mix(a.Pitch, b.Pitch, t);
+    c.updateCameraVectors();
+    return c;
+}
+
 // Recalculate Front, Right, and Up vectors
 void Camera::updateCameraVectors() {
     glm::vec3 front;
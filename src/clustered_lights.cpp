@@ -0,0 +1,214 @@
+#include "clustered_lights.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+ClusteredLights::ClusteredLights()
+    : buffers{0, 0, 0}, textures{0, 0, 0}, boundsProj(0.0f), boundsNear(0.0f), boundsFar(0.0f) {}
+
+void ClusteredLights::init() {
+    if (buffers[0]) return;
+    const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R32UI};
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+    for (int i = 0; i < 3; ++i) {
+        // A buffer texture needs storage behind it before it is sampled
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    slicePairs.resize(kClusterZ);
+}
+
+void ClusteredLights::destroy() {
+    if (!buffers[0]) return;
+    glDeleteTextures(3, textures);
+    glDeleteBuffers(3, buffers);
+    for (int i = 0; i < 3; ++i) buffers[i] = textures[i] = 0;
+    bounds.clear();
+}
+
+void ClusteredLights::bind() const {
+    const GLint units[3] = {LIGHT_DATA_UNIT, LIGHT_GRID_UNIT, LIGHT_INDEX_UNIT};
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + units[i]);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// Orphan and refill: last frame's contents may still be in use by the GPU
+void ClusteredLights::upload(GLuint buffer, const void* data, size_t bytes) {
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 16), nullptr, GL_STREAM_DRAW);
+    if (bytes) glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+}
+
+// Depth slices are spaced exponentially: slice = log(d) * scale + bias
+static float sliceScale(float zNear, float zFar) { return kClusterZ / std::log(zFar / zNear); }
+static float sliceBias(float zNear, float zFar)  { return -kClusterZ * std::log(zNear) / std::log(zFar / zNear); }
+
+static float sliceDepth(int z, float zNear, float zFar) {
+    return zNear * std::pow(zFar / zNear, (float)z / kClusterZ);
+}
+
+// View-space x (or y) of NDC coordinate n at distance d in front of the camera
+static float unproject(float n, float d, float scale, float offset) {
+    return (n + offset) * d / scale;
+}
+
+void ClusteredLights::buildBounds(const glm::mat4& proj, float zNear, float zFar) {
+    if (!bounds.empty() && proj == boundsProj && zNear == boundsNear && zFar == boundsFar) return;
+    boundsProj = proj;
+    boundsNear = zNear;
+    boundsFar  = zFar;
+
+    bounds.assign(kClusterCount, AABB());
+    for (int z = 0; z < kClusterZ; ++z) {
+        float d[2] = {sliceDepth(z, zNear, zFar), sliceDepth(z + 1, zNear, zFar)};
+        for (int y = 0; y < kClusterY; ++y) {
+            float ny[2] = {-1.0f + 2.0f * y / kClusterY, -1.0f + 2.0f * (y + 1) / kClusterY};
+            for (int x = 0; x < kClusterX; ++x) {
+                float nx[2] = {-1.0f + 2.0f * x / kClusterX, -1.0f + 2.0f * (x + 1) / kClusterX};
+                AABB& b = bounds[(z * kClusterY + y) * kClusterX + x];
+                for (int i = 0; i < 8; ++i) {
+                    float depth = d[i >> 2];
+                    b.expand(glm::vec3(unproject(nx[i & 1], depth, proj[0][0], proj[2][0]),
+                                       unproject(ny[(i >> 1) & 1], depth, proj[1][1], proj[2][1]),
+                                       -depth));
+                }
+            }
+        }
+    }
+}
+
+// Screen tile range [t0, t1] covered by view-space interval [lo, hi] between
+// distances d0 and d1 (conservative: extremes of the box's corners)
+static void tileRange(float lo, float hi, float d0, float d1, float scale, float offset,
+                      int tiles, int& t0, int& t1) {
+    float nMin = 1e30f, nMax = -1e30f;
+    for (float v : {lo, hi})
+        for (float d : {d0, d1}) {
+            float n = v * scale / d - offset;
+            nMin = std::min(nMin, n);
+            nMax = std::max(nMax, n);
+        }
+    t0 = std::max(0, (int)std::floor((nMin * 0.5f + 0.5f) * tiles));
+    t1 = std::min(tiles - 1, (int)std::floor((nMax * 0.5f + 0.5f) * tiles));
+}
+
+static bool sphereTouches(const AABB& box, const glm::vec3& c, float r) {
+    glm::vec3 nearest = glm::clamp(c, box.min, box.max);
+    glm::vec3 delta   = nearest - c;
+    return glm::dot(delta, delta) <= r * r;
+}
+
+void ClusteredLights::assignSlice(int z) {
+    std::vector<std::uint32_t>& pairs = slicePairs[z];
+    pairs.clear();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        const LightRange& l = ranges[i];
+        if (z < l.z0 || z > l.z1) continue;
+        for (int y = l.y0; y <= l.y1; ++y)
+            for (int x = l.x0; x <= l.x1; ++x) {
+                int cell = y * kClusterX + x;
+                if (sphereTouches(bounds[z * kClusterX * kClusterY + cell], l.position, l.radius))
+                    pairs.push_back((std::uint32_t)cell << 16 | (std::uint32_t)i);
+            }
+    }
+    // Groups each cell's lights together, in light order
+    std::sort(pairs.begin(), pairs.end());
+}
+
+ClusterConstants ClusteredLights::build(const std::vector<PointLight>& lights,
+                                        const glm::mat4& view, const glm::mat4& proj,
+                                        float zNear, float zFar, int width, int height, JobSystem& jobs,
+                                        std::pmr::memory_resource* scratch) {
+    PROFILE_SCOPE("ClusteredLights::build");
+    auto start = std::chrono::steady_clock::now();
+    init();
+    buildBounds(proj, zNear, zFar);
+
+    const float scale = sliceScale(zNear, zFar);
+    const float bias  = sliceBias(zNear, zFar);
+    auto slice = [&](float d) { return std::min(kClusterZ - 1, std::max(0, (int)std::floor(std::log(d) * scale + bias))); };
+
+    // View-space lights and the froxel range each may touch
+    ranges.clear();
+    lightData.clear();
+    const size_t count = std::min(lights.size(), (size_t)kMaxClusteredLights);
+    for (size_t i = 0; i < count; ++i) {
+        const PointLight& light = lights[i];
+        glm::vec3 p = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float dMin = -p.z - light.radius;
+        float dMax = -p.z + light.radius;
+
+        LightRange r;
+        r.position = p;
+        r.radius   = light.radius;
+        if (dMax < zNear || dMin > zFar) {
+            r.z0 = 1;   // behind the camera or past the far plane: no slice
+            r.z1 = 0;
+        } else {
+            r.z0 = slice(std::max(dMin, zNear));
+            r.z1 = slice(std::min(dMax, zFar));
+        }
+        if (dMin <= zNear) {
+            // Reaches the camera plane: projection blows up, take every tile
+            r.x0 = r.y0 = 0;
+            r.x1 = kClusterX - 1;
+            r.y1 = kClusterY - 1;
+        } else {
+            tileRange(p.x - light.radius, p.x + light.radius, dMin, dMax, proj[0][0], proj[2][0], kClusterX, r.x0, r.x1);
+            tileRange(p.y - light.radius, p.y + light.radius, dMin, dMax, proj[1][1], proj[2][1], kClusterY, r.y0, r.y1);
+        }
+        ranges.push_back(r);
+        lightData.push_back(glm::vec4(p, light.radius));
+        lightData.push_back(glm::vec4(light.color, 0.0f));
+    }
+
+    // One job per depth slice: each writes only its own pair list
+    jobs.parallelFor(0, kClusterZ, 1, [this](int begin, int end) {
+        for (int z = begin; z < end; ++z) assignSlice(z);
+    });
+
+    // Flatten into (first, count) per cluster plus one index list
+    grid.assign(kClusterCount, glm::uvec2(0));
+    indices.clear();
+    counters = ClusterStats();
+    std::pmr::vector<bool> touched(count, false, scratch);
+    for (int z = 0; z < kClusterZ; ++z) {
+        const std::vector<std::uint32_t>& pairs = slicePairs[z];
+        for (size_t i = 0; i < pairs.size();) {
+            std::uint32_t cell = pairs[i] >> 16;
+            glm::uvec2& g = grid[z * kClusterX * kClusterY + cell];
+            g.x = (std::uint32_t)indices.size();
+            for (; i < pairs.size() && (pairs[i] >> 16) == cell; ++i) {
+                std::uint32_t light = pairs[i] & 0xffffu;
+                indices.push_back(light);
+                touched[light] = true;
+            }
+            g.y = (std::uint32_t)indices.size() - g.x;
+            counters.maxPerCluster = std::max(counters.maxPerCluster, (int)g.y);
+        }
+    }
+
+    upload(buffers[0], lightData.data(), lightData.size() * sizeof(glm::vec4));
+    upload(buffers[1], grid.data(), grid.size() * sizeof(glm::uvec2));
+    upload(buffers[2], indices.data(), indices.size() * sizeof(std::uint32_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    counters.lights        = (int)count;
+    counters.visibleLights = (int)std::count(touched.begin(), touched.end(), true);
+    counters.indices       = (int)indices.size();
+    counters.buildMs       = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    ClusterConstants c;
+    c.dims   = glm::uvec4(kClusterX, kClusterY, kClusterZ, (unsigned)count);
+    c.params = glm::vec4(scale, bias, (float)width / kClusterX, (float)height / kClusterY);
+    return c;
+}
@@ -0,0 +1,171 @@
+#include "culling.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CULLING_SIMD 1
+#endif
+
+// Boxes per BVH leaf
+static const int kLeafSize = 4;
+
+AABB transformBounds(const glm::mat4& m, const AABB& local) {
+    if (local.empty()) return local;
+
+    // Arvo: new centre is the transformed centre, new extent is |M| * extent
+    glm::vec3 c = glm::vec3(m * glm::vec4(local.center(), 1.0f));
+    glm::vec3 e = local.extent();
+    glm::vec3 r(0.0f);
+    for (int col = 0; col < 3; ++col)
+        r += glm::abs(glm::vec3(m[col])) * e[col];
+
+    AABB out;
+    out.min = c - r;
+    out.max = c + r;
+    return out;
+}
+
+Frustum::Frustum() {
+    for (int i = 0; i < 8; ++i) {
+        nx[i] = ny[i] = nz[i] = ax[i] = ay[i] = az[i] = 0.0f;
+        d[i] = 1.0f;
+    }
+}
+
+Frustum::Frustum(const glm::mat4& vp) : Frustum() {
+    // Gribb-Hartmann: each plane is row 3 +/- row i of the matrix
+    for (int i = 0; i < 6; ++i) {
+        int   row  = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        nx[i] = vp[0][3] + sign * vp[0][row];
+        ny[i] = vp[1][3] + sign * vp[1][row];
+        nz[i] = vp[2][3] + sign * vp[2][row];
+        d[i]  = vp[3][3] + sign * vp[3][row];
+        ax[i] = std::fabs(nx[i]);
+        ay[i] = std::fabs(ny[i]);
+        az[i] = std::fabs(nz[i]);
+    }
+}
+
+Containment Frustum::classify(const AABB& box) const {
+    if (box.empty()) return Containment::Outside;
+    glm::vec3 c = box.center();
+    glm::vec3 e = box.extent();
+
+#if CULLING_SIMD
+    // dist = n.c + d, radius = |n|.e; outside one plane if dist + radius < 0
+    const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+    const __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+    const __m128 zero = _mm_setzero_ps();
+    int outside = 0, crossing = 0;
+    for (int i = 0; i < 8; i += 4) {
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(nx + i), cx),
+                                            _mm_mul_ps(_mm_load_ps(ny + i), cy)),
+                                 _mm_add_ps(_mm_mul_ps(_mm_load_ps(nz + i), cz),
+                                            _mm_load_ps(d + i)));
+        __m128 rad  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(ax + i), ex),
+                                            _mm_mul_ps(_mm_load_ps(ay + i), ey)),
+                                 _mm_mul_ps(_mm_load_ps(az + i), ez));
+        outside  |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, rad), zero));
+        crossing |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, rad), zero));
+    }
+    if (outside) return Containment::Outside;
+    return crossing ? Containment::Intersects : Containment::Inside;
+#else
+    bool crossing = false;
+    for (int i = 0; i < 6; ++i) {
+        float dist = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + d[i];
+        float rad  = ax[i] * e.x + ay[i] * e.y + az[i] * e.z;
+        if (dist + rad < 0.0f) return Containment::Outside;
+        if (dist - rad < 0.0f) crossing = true;
+    }
+    return crossing ? Containment::Intersects : Containment::Inside;
+#endif
+}
+
+void Bvh::build(const std::vector<AABB>& boxes) {
+    items = boxes;
+    order.resize(boxes.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (int)i;
+    nodes.clear();
+    if (!items.empty()) buildNode(0, (int)items.size());
+}
+
+// Median split on the longest axis of the centroid bounds
+int Bvh::buildNode(int first, int count) {
+    int index = (int)nodes.size();
+    nodes.emplace_back();
+    nodes[index].first = first;
+    nodes[index].count = count;
+
+    AABB centers;
+    for (int i = first; i < first + count; ++i) {
+        nodes[index].box.expand(items[order[i]]);
+        centers.expand(items[order[i]].center());
+    }
+    if (count <= kLeafSize) return index;
+
+    glm::vec3 size = centers.max - centers.min;
+    int axis = (size.y > size.x) ? 1 : 0;
+    if (size.z > size[axis]) axis = 2;
+
+    int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [&](int a, int b) { return items[a].center()[axis] < items[b].center()[axis]; });
+
+    int left  = buildNode(first, half);
+    int right = buildNode(first + half, count - half);
+    nodes[index].left  = left;
+    nodes[index].right = right;
+    return index;
+}
+
+void Bvh::refit(const AABB* boxes) {
+    std::copy(boxes, boxes + items.size(), items.begin());
+    // Reverse order visits children before parents
+    for (int n = (int)nodes.size() - 1; n >= 0; --n) {
+        Node& node = nodes[n];
+        node.box = AABB();
+        if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                node.box.expand(items[order[i]]);
+        } else {
+            node.box.expand(nodes[node.left].box);
+            node.box.expand(nodes[node.right].box);
+        }
+    }
+}
+
+void Bvh::cull(const Frustum& frustum, std::vector<int>& visible, CullStats& stats) const {
+    if (nodes.empty()) return;
+    size_t before = visible.size();
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        ++stats.tests;
+        Containment c = frustum.classify(node.box);
+        if (c == Containment::Outside) continue;
+
+        if (c == Containment::Inside) {
+            // Whole subtree visible: no further tests
+            visible.insert(visible.end(), order.begin() + node.first,
+                           order.begin() + node.first + node.count);
+        } else if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                ++stats.tests;
+                if (frustum.visible(items[order[i]])) visible.push_back(order[i]);
+            }
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+
+    int found = (int)(visible.size() - before);
+    stats.visible += found;
+    stats.culled  += size() - found;
+}
@@ -0,0 +1,40 @@
+#include "frame_arena.h"
+#include <cstdint>
+
+FrameArena::FrameArena(std::size_t capacity)
+    : block(new unsigned char[capacity]), size(capacity), offset(0), overflowBytes(0), adapter(this) {}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t align) {
+    std::uintptr_t base    = reinterpret_cast<std::uintptr_t>(block.get());
+    std::uintptr_t aligned = (base + offset + align - 1) & ~(std::uintptr_t)(align - 1);
+    std::size_t    end     = (aligned - base) + bytes;
+    if (end <= size) {
+        offset = end;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Out of room: serve from the heap until the next reset
+    overflow.emplace_back(new unsigned char[bytes + align]);
+    overflowBytes += bytes + align;
+    std::uintptr_t p = reinterpret_cast<std::uintptr_t>(overflow.back().get());
+    return reinterpret_cast<void*>((p + align - 1) & ~(std::uintptr_t)(align - 1));
+}
+
+void FrameArena::reset() {
+    if (!overflow.empty()) {
+        // Grow so the peak frame fits in one block next time
+        size += overflowBytes;
+        block.reset(new unsigned char[size]);
+        overflow.clear();
+        overflowBytes = 0;
+    }
+    offset = 0;
+}
+
+FrameMemory::FrameMemory(std::size_t capacity)
+    : arenas{FrameArena(capacity), FrameArena(capacity)}, index(0) {}
+
+void FrameMemory::beginFrame() {
+    index ^= 1;
+    arenas[index].reset();
+}
@@ -0,0 +1,256 @@
+#include "frame_capture.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+FrameCapture::FrameCapture()
+    : width(0), height(0), running(false), oldest(0), inFlight(0),
+      nextSequence(0), quit(false), stream(nullptr), nextWrite(0) {}
+
+FrameCapture::~FrameCapture() {
+    stop();
+}
+
+CaptureFormat FrameCapture::formatFor(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return ext == ".y4m" ? CaptureFormat::Y4M : CaptureFormat::PNG;
+}
+
+bool FrameCapture::start(int w, int h, const CaptureSettings& settings) {
+    stop();
+    config   = settings;
+    width    = w;
+    height   = h;
+    counters = CaptureStats();
+
+    if (config.format == CaptureFormat::Y4M) {
+        stream = std::fopen(config.path.c_str(), "wb");
+        if (!stream) {
+            std::cerr << "FrameCapture: cannot open " << config.path << "\n";
+            return false;
+        }
+        std::fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, config.fps);
+    } else {
+        std::error_code ec;
+        std::filesystem::create_directories(config.path, ec);
+        if (ec) {
+            std::cerr << "FrameCapture: cannot create " << config.path << "\n";
+            return false;
+        }
+    }
+
+    const GLsizeiptr bytes = (GLsizeiptr)width * height * 4;
+    for (Readback& r : readbacks) {
+        glGenBuffers(1, &r.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    oldest = inFlight = 0;
+
+    // Every worker may hold one frame while queueDepth more wait
+    config.workers    = std::max(1, config.workers);
+    config.queueDepth = std::max(1, config.queueDepth);
+    pool.assign(config.workers + config.queueDepth, std::vector<unsigned char>((size_t)bytes));
+    freeSlots.clear();
+    for (int i = 0; i < (int)pool.size(); ++i) freeSlots.push_back(i);
+    nextSequence = nextWrite = 0;
+
+    quit = false;
+    for (int i = 0; i < config.workers; ++i)
+        workers.emplace_back(&FrameCapture::workerLoop, this);
+    running = true;
+    return true;
+}
+
+void FrameCapture::stop() {
+    if (!running) return;
+    collect(true);
+    for (Readback& r : readbacks) {
+        glDeleteBuffers(1, &r.pbo);
+        r.pbo = 0;
+    }
+
+    // Workers finish the queue before they see quit
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+    quit = false;
+
+    if (stream) std::fclose(stream);
+    stream = nullptr;
+    pool.clear();
+    running = false;
+}
+
+void FrameCapture::capture() {
+    if (!running) return;
+    PROFILE_SCOPE("FrameCapture::capture");
+    auto start = std::chrono::steady_clock::now();
+
+    // Lossless: drain the ring when it is full instead of dropping
+    collect(config.lossless && inFlight == kCapturePbos);
+
+    // The GPU is more than kCapturePbos frames behind: skip rather than wait
+    bool dropped = inFlight == kCapturePbos;
+    if (!dropped) {
+        Readback& r = readbacks[(oldest + inFlight) % kCapturePbos];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++inFlight;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counters.frames;
+    if (dropped) ++counters.droppedReadback;
+    counters.captureMsTotal += ms;
+    counters.captureMsMax    = std::max(counters.captureMsMax, ms);
+}
+
+void FrameCapture::collect(bool wait) {
+    const size_t rowBytes = (size_t)width * 4;
+    while (inFlight > 0) {
+        Readback& r = readbacks[oldest];
+        GLenum status = wait ? glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull)
+                             : glClientWaitSync(r.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) break;
+        glDeleteSync(r.fence);
+        r.fence = nullptr;
+        oldest = (oldest + 1) % kCapturePbos;
+        --inFlight;
+
+        int slot = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Only a drain or a lossless capture waits for an encoder to free a slot
+            if (wait || config.lossless) slotFreed.wait(lock, [this] { return !freeSlots.empty(); });
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                ++counters.droppedQueue;
+            }
+        }
+        if (slot < 0) continue;
+
+        // GL rows run bottom-up; the pool holds them top-down
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+        const unsigned char* src = (const unsigned char*)glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, rowBytes * height, GL_MAP_READ_BIT);
+        if (src) {
+            unsigned char* dst = pool[slot].data();
+            for (int y = 0; y < height; ++y)
+                std::memcpy(dst + (size_t)(height - 1 - y) * rowBytes, src + (size_t)y * rowBytes, rowBytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!src) {
+            freeSlots.push_back(slot);
+            continue;
+        }
+        queue.push_back({slot, nextSequence++});
+        ++counters.queued;
+        wake.notify_one();
+    }
+}
+
+void FrameCapture::workerLoop() {
+    PROFILE_THREAD_NAME("capture encoder");
+    std::vector<unsigned char> scratch;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return quit || !queue.empty(); });
+        if (queue.empty()) return;   // quit, and nothing left to encode
+
+        Job job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            PROFILE_SCOPE("FrameCapture::encode");
+            encode(job, scratch);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        freeSlots.push_back(job.slot);
+        ++counters.written;
+        counters.encodeMsTotal += ms;
+        slotFreed.notify_all();
+    }
+}
+
+// RGB -> full-range BT.601 (the "jpeg" colour range of the Y4M header)
+static unsigned char lumaOf(const unsigned char* p) {
+    return (unsigned char)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+}
+
+void FrameCapture::encode(const Job& job, std::vector<unsigned char>& scratch) {
+    const unsigned char* rgba = pool[job.slot].data();
+    const int pixels = width * height;
+
+    if (config.format == CaptureFormat::PNG) {
+        // The default framebuffer's alpha is undefined: write RGB
+        scratch.resize((size_t)pixels * 3);
+        for (int i = 0; i < pixels; ++i) std::memcpy(&scratch[i * 3], rgba + i * 4, 3);
+        char name[32];
+        std::snprintf(name, sizeof(name), "/frame_%06llu.png", (unsigned long long)job.sequence);
+        if (!stbi_write_png((config.path + name).c_str(), width, height, 3, scratch.data(), width * 3))
+            std::cerr << "FrameCapture: cannot write " << config.path << name << "\n";
+        return;
+    }
+
+    // 4:2:0: full-size Y, then U and V averaged over 2x2 blocks
+    const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    scratch.resize((size_t)pixels + 2 * (size_t)cw * ch);
+    unsigned char* Y = scratch.data();
+    unsigned char* U = Y + pixels;
+    unsigned char* V = U + (size_t)cw * ch;
+    for (int i = 0; i < pixels; ++i) Y[i] = lumaOf(rgba + i * 4);
+    for (int cy = 0; cy < ch; ++cy)
+        for (int cx = 0; cx < cw; ++cx) {
+            int r = 0, g = 0, b = 0, n = 0;
+            for (int dy = 0; dy < 2; ++dy)
+                for (int dx = 0; dx < 2; ++dx) {
+                    int x = cx * 2 + dx, y = cy * 2 + dy;
+                    if (x >= width || y >= height) continue;
+                    const unsigned char* p = rgba + ((size_t)y * width + x) * 4;
+                    r += p[0]; g += p[1]; b += p[2]; ++n;
+                }
+            r /= n; g /= n; b /= n;
+            U[cy * cw + cx] = (unsigned char)std::min(255, std::max(0, ((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128));
+            V[cy * cw + cx] = (unsigned char)std::min(255, std::max(0, ((128 * r - 107 * g - 21 * b + 128) >> 8) + 128));
+        }
+
+    // Conversion runs in parallel; the stream is written strictly in order
+    std::unique_lock<std::mutex> lock(streamMutex);
+    streamTurn.wait(lock, [&] { return nextWrite == job.sequence; });
+    std::fputs("FRAME\n", stream);
+    std::fwrite(scratch.data(), 1, scratch.size(), stream);
+    ++nextWrite;
+    streamTurn.notify_all();
+}
+
+CaptureStats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
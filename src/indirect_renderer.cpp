@@ -0,0 +1,113 @@
+#include "indirect_renderer.h"
+#include <cstdint>
+
+// GL 4.3 pieces the bundled (4.1) loader does not provide
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+typedef void (APIENTRYP PFNMULTIDRAWELEMENTSINDIRECT)(GLenum mode, GLenum type, const void* indirect,
+                                                     GLsizei drawcount, GLsizei stride);
+static PFNMULTIDRAWELEMENTSINDIRECT multiDrawElementsIndirect = nullptr;
+
+// Per-draw id attribute (after the crowd's instance attributes 2..9)
+static const GLuint kDrawIdAttribute = 10;
+
+IndirectRenderer::IndirectRenderer()
+    : ready(false), vao(0), drawIdBuffer(0), commandBuffer(0), drawDataBuffer(0),
+      capacity(0), lastDrawCalls(0) {}
+
+bool IndirectRenderer::init(GLADloadproc load) {
+    if (ready) return true;
+    if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 3)) return false;
+    multiDrawElementsIndirect = (PFNMULTIDRAWELEMENTSINDIRECT)load("glMultiDrawElementsIndirect");
+    if (!multiDrawElementsIndirect) return false;
+
+    meshRegistry().init();
+    vao = meshRegistry().makeVertexArray();
+    glGenBuffers(1, &drawIdBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &drawDataBuffer);
+    glBindVertexArray(0);
+    reserve(1024);
+    ready = true;
+    return true;
+}
+
+void IndirectRenderer::destroy() {
+    if (drawDataBuffer) glDeleteBuffers(1, &drawDataBuffer);
+    if (commandBuffer) glDeleteBuffers(1, &commandBuffer);
+    if (drawIdBuffer) glDeleteBuffers(1, &drawIdBuffer);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    vao = drawIdBuffer = commandBuffer = drawDataBuffer = 0;
+    capacity = 0;
+    ready = false;
+}
+
+// Make the id attribute cover at least n draws
+void IndirectRenderer::reserve(GLsizei n) {
+    if (n <= capacity) return;
+    while (capacity < n) capacity = capacity ? capacity * 2 : 1024;
+
+    std::vector<GLuint> ids(capacity);
+    for (GLsizei i = 0; i < capacity; ++i) ids[i] = (GLuint)i;
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+    glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(kDrawIdAttribute, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glEnableVertexAttribArray(kDrawIdAttribute);
+    glVertexAttribDivisor(kDrawIdAttribute, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void IndirectRenderer::add(const Mesh& mesh, const glm::mat4& modelView, const glm::mat3& normal,
+                           const glm::vec3& color) {
+    ModeList* list = nullptr;
+    for (ModeList& l : lists)
+        if (l.mode == mesh.mode) list = &l;
+    if (!list) {
+        lists.push_back({mesh.mode, {}});
+        list = &lists.back();
+    }
+
+    GLuint id = (GLuint)draws.size();
+    list->commands.push_back({(GLuint)mesh.count, 1, mesh.firstIndex, mesh.baseVertex, id});
+
+    IndirectDrawData d;
+    d.modelView = modelView;
+    for (int c = 0; c < 3; ++c) d.normal[c] = glm::vec4(normal[c], 0.0f);
+    d.color = glm::vec4(color, 1.0f);
+    draws.push_back(d);
+}
+
+void IndirectRenderer::submit(Shader& program) {
+    lastDrawCalls = 0;
+    if (draws.empty()) return;
+    reserve((GLsizei)draws.size());
+
+    packed.clear();
+    for (const ModeList& l : lists) packed.insert(packed.end(), l.commands.begin(), l.commands.end());
+
+    // Orphan and refill: the driver hands back fresh storage if the GPU still reads the old one
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawDataBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, draws.size() * sizeof(IndirectDrawData), draws.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kDrawDataBinding, drawDataBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, packed.size() * sizeof(Command), packed.data(), GL_STREAM_DRAW);
+
+    program.use();
+    glBindVertexArray(vao);
+    std::uintptr_t offset = 0;
+    for (ModeList& l : lists) {
+        if (l.commands.empty()) continue;
+        multiDrawElementsIndirect(l.mode, GL_UNSIGNED_INT, (const void*)offset,
+                                  (GLsizei)l.commands.size(), sizeof(Command));
+        offset += l.commands.size() * sizeof(Command);
+        ++lastDrawCalls;
+        l.commands.clear();
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    draws.clear();
+}
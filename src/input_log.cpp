@@ -0,0 +1,183 @@
+#include "input_log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const char kLogMagic[4] = {'R', 'I', 'N', '1'};
+static const size_t kHeaderBytes = 4 + 4 + 8;
+
+// Fields present in an event
+enum EventField : std::uint8_t {
+    EVENT_KEYS   = 1 << 0,
+    EVENT_MOUSE  = 1 << 1,
+    EVENT_SCENE  = 1 << 2,
+    EVENT_CAMERA = 1 << 3
+};
+
+// Held keys as bits, in InputState order
+static std::uint8_t keyBits(const InputState& in) {
+    return (std::uint8_t)((in.forward  ? 1 : 0) | (in.backward ? 2 : 0) | (in.left    ? 4 : 0) |
+                          (in.right    ? 8 : 0) | (in.armUp   ? 16 : 0) | (in.armDown ? 32 : 0));
+}
+
+static void applyKeys(InputState& in, std::uint8_t bits) {
+    in.forward  = bits & 1;
+    in.backward = bits & 2;
+    in.left     = bits & 4;
+    in.right    = bits & 8;
+    in.armUp    = bits & 16;
+    in.armDown  = bits & 32;
+}
+
+// Raw little-endian scalars (the log is written and read on the same kind of machine)
+template <typename T>
+static void put(std::vector<std::uint8_t>& out, T value) {
+    const std::uint8_t* p = (const std::uint8_t*)&value;
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static bool get(const std::vector<std::uint8_t>& in, size_t& at, T& value) {
+    if (at + sizeof(T) > in.size()) return false;
+    std::memcpy(&value, &in[at], sizeof(T));
+    at += sizeof(T);
+    return true;
+}
+
+static void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((std::uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((std::uint8_t)v);
+}
+
+static bool getVarint(const std::vector<std::uint8_t>& in, size_t& at, std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && at < in.size(); shift += 7) {
+        std::uint8_t b = in[at++];
+        v |= (std::uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// ------------------------------------------------
+// Recording
+// ------------------------------------------------
+void InputRecorder::begin(double hz) {
+    events.clear();
+    rate      = (std::uint32_t)std::lround(hz);
+    stepCount = 0;
+    lastEvent = 0;
+    heldKeys  = 0;
+    active    = true;
+}
+
+void InputRecorder::record(std::uint64_t tick, const InputState& in) {
+    if (!active) return;
+    stepCount = tick + 1;
+
+    std::uint8_t keys = keyBits(in);
+    std::uint8_t mask = 0;
+    if (keys != heldKeys)                         mask |= EVENT_KEYS;
+    if (in.mouseDX != 0.0f || in.mouseDY != 0.0f) mask |= EVENT_MOUSE;
+    if (in.scene)                                 mask |= EVENT_SCENE;
+    if (in.cameraMode)                            mask |= EVENT_CAMERA;
+    if (!mask) return;
+
+    putVarint(events, tick - lastEvent);
+    events.push_back(mask);
+    if (mask & EVENT_KEYS)   events.push_back(keys);
+    if (mask & EVENT_MOUSE)  { put(events, in.mouseDX); put(events, in.mouseDY); }
+    if (mask & EVENT_SCENE)  events.push_back((std::uint8_t)in.scene);
+    if (mask & EVENT_CAMERA) events.push_back((std::uint8_t)in.cameraMode);
+    lastEvent = tick;
+    heldKeys  = keys;
+}
+
+bool InputRecorder::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "InputRecorder: cannot write " << path << "\n";
+        return false;
+    }
+    std::vector<std::uint8_t> header(kLogMagic, kLogMagic + 4);
+    put(header, rate);
+    put(header, stepCount);
+    file.write((const char*)header.data(), header.size());
+    file.write((const char*)events.data(), events.size());
+    return (bool)file;
+}
+
+// ------------------------------------------------
+// Replay
+// ------------------------------------------------
+bool InputReplay::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t at = 4;
+    if (data.size() < kHeaderBytes || std::memcmp(data.data(), kLogMagic, 4) != 0 ||
+        !get(data, at, rate) || !get(data, at, stepCount) || rate == 0) {
+        std::cerr << "InputReplay: " << path << " is not an input log\n";
+        return false;
+    }
+    events.assign(data.begin() + kHeaderBytes, data.end());
+    return true;
+}
+
+void InputReplay::readEventTick() {
+    std::uint64_t delta = 0;
+    hasEvent = getVarint(events, cursor, delta);
+    if (hasEvent) nextEvent += delta;
+}
+
+InputState InputReplay::inputFor(std::uint64_t tick) {
+    InputState in;
+    if (hasEvent && nextEvent == tick) {
+        std::uint8_t mask = 0;
+        get(events, cursor, mask);
+        if (mask & EVENT_KEYS) get(events, cursor, heldKeys);
+        if (mask & EVENT_MOUSE) { get(events, cursor, in.mouseDX); get(events, cursor, in.mouseDY); }
+        std::uint8_t value = 0;
+        if ((mask & EVENT_SCENE)  && get(events, cursor, value)) in.scene = value;
+        if ((mask & EVENT_CAMERA) && get(events, cursor, value)) in.cameraMode = value;
+        readEventTick();
+    }
+    applyKeys(in, heldKeys);
+    return in;
+}
+
+void InputReplay::start(const SimState& initial) {
+    cursor     = 0;
+    nextEvent  = 0;
+    heldKeys   = 0;
+    state      = previous = initial;
+    frameCount = 0;
+    caughtUp   = false;
+    readEventTick();
+}
+
+SimState InputReplay::frame(double frameSeconds) {
+    const double dt = 1.0 / rate;
+    ++frameCount;
+
+    // Virtual time from the frame count, never from a clock
+    double now = frameCount * frameSeconds;
+    std::uint64_t due = std::min(stepCount, (std::uint64_t)(now / dt));
+    while (state.tick < due) {
+        previous = state;
+        stepSimulation(state, inputFor(state.tick), (float)dt);
+    }
+
+    // Same blend as Simulation::sample: one step behind the newest
+    now -= dt;
+    double span = state.time - previous.time;
+    float alpha = span > 0.0 ? (float)((now - previous.time) / span) : 1.0f;
+    caughtUp = alpha >= 1.0f;
+    return interpolate(previous, state, std::clamp(alpha, 0.0f, 1.0f));
+}
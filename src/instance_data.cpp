@@ -0,0 +1,20 @@
+#include "instance_data.h"
+#include <cstddef>
+
+void enableInstanceAttributes() {
+    for (GLuint a = 2; a <= 9; ++a) {
+        glEnableVertexAttribArray(a);
+        glVertexAttribDivisor(a, 1);
+    }
+}
+
+void setInstanceLayout(GLintptr offset) {
+    const GLsizei stride = sizeof(InstanceData);
+    for (int c = 0; c < 4; ++c)   // model matrix columns
+        glVertexAttribPointer(2 + c, 4, GL_FLOAT, GL_FALSE, stride,
+                              (void*)(offset + offsetof(InstanceData, model) + c * sizeof(glm::vec4)));
+    for (int c = 0; c < 3; ++c)   // normal matrix columns
+        glVertexAttribPointer(6 + c, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void*)(offset + offsetof(InstanceData, normal) + c * sizeof(glm::vec3)));
+    glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(InstanceData, color)));
+}
@@ -0,0 +1,126 @@
+#include "job_system.h"
+#include "profiler.h"
+#include <algorithm>
+
+JobSystem::JobSystem(int workerCount) : queued(0), quit(false) {
+    if (workerCount < 0)
+        workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+
+    for (int i = 0; i <= workerCount; ++i)
+        queues.emplace_back(new Queue());
+    for (int i = 1; i <= workerCount; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+// Split the range into chunks, deal them round-robin, then help until done
+void JobSystem::dispatch(int begin, int end, int grain,
+                         void (*invoke)(void*, int, int), void* ctx) {
+    if (end <= begin) return;
+    grain = std::max(1, grain);
+
+    // Small ranges or no workers: run inline
+    if (workers.empty() || end - begin <= grain) {
+        invoke(ctx, begin, end);
+        return;
+    }
+
+    std::atomic<int> pending(0);
+    int chunks = (end - begin + grain - 1) / grain;
+    pending = chunks;
+
+    for (int c = 0; c < chunks; ++c) {
+        int b = begin + c * grain;
+        Job job = {invoke, ctx, b, std::min(end, b + grain), &pending};
+        Queue& q = *queues[c % queues.size()];
+        std::lock_guard<std::mutex> lock(q.m);
+        q.pushBack(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued += chunks;
+    }
+    wake.notify_all();
+
+    // The caller is thread 0: drain its own deque, then steal
+    Job job;
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (popOrSteal(0, job)) run(job);
+        else std::this_thread::yield();
+    }
+}
+
+void JobSystem::Queue::pushBack(const Job& job) {
+    if (count == ring.size()) {
+        // Full: unroll into a larger ring, oldest first
+        std::vector<Job> grown(std::max<size_t>(16, ring.size() * 2));
+        for (size_t i = 0; i < count; ++i) grown[i] = ring[(head + i) % ring.size()];
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count++) % ring.size()] = job;
+}
+
+JobSystem::Job JobSystem::Queue::popBack() {
+    return ring[(head + --count) % ring.size()];
+}
+
+JobSystem::Job JobSystem::Queue::popFront() {
+    Job job = ring[head];
+    head = (head + 1) % ring.size();
+    --count;
+    return job;
+}
+
+bool JobSystem::popOrSteal(int self, Job& job) {
+    // Own deque: newest first (LIFO keeps caches warm)
+    {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.count) {
+            job = q.popBack();
+            --queued;
+            return true;
+        }
+    }
+    // Steal the oldest job from another thread
+    int n = (int)queues.size();
+    for (int i = 1; i < n; ++i) {
+        Queue& q = *queues[(self + i) % n];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.count) {
+            job = q.popFront();
+            --queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::run(Job& job) {
+    PROFILE_SCOPE("job");
+    job.invoke(job.ctx, job.begin, job.end);
+    job.pending->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::workerLoop(int self) {
+    PROFILE_THREAD_NAME("worker", self);
+    Job job;
+    for (;;) {
+        if (popOrSteal(self, job)) {
+            run(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return quit || queued > 0; });
+        if (quit) return;
+    }
+}
@@ -0,0 +1,47 @@
+#include "lod.h"
+#include "mesh_registry.h"
+#include "culling.h"
+#include <algorithm>
+#include <cfloat>
+
+// Projected diameters (pixels) separating level i from level i + 1
+static const float kLodPixels[kLodLevels - 1] = {32.0f, 12.0f};
+// Fraction an object has to move past a boundary before its level changes
+static const float kLodHysteresis = 0.2f;
+// Coarsest ring count still recognisable as round
+static const int kMinTessellation = 6;
+
+int lodTessellation(int fullTessellation, int level) {
+    if (fullTessellation == 0) return 0;
+    return std::max(fullTessellation >> level, kMinTessellation);
+}
+
+LodView makeLodView(const glm::mat4& view, const glm::mat4& proj, int viewportHeight) {
+    LodView lod;
+    lod.eye        = glm::vec3(glm::inverse(view)[3]);
+    lod.pixelScale = proj[1][1] * viewportHeight * 0.5f;
+    return lod;
+}
+
+float projectedPixels(const LodView& lod, const glm::vec3& center, float diameter) {
+    if (lod.pixelScale <= 0.0f) return FLT_MAX;
+    // Distance to the eye rather than view depth, so turning the camera never changes a level
+    float dist = std::max(glm::length(center - lod.eye), 1e-3f);
+    return diameter * lod.pixelScale / dist;
+}
+
+int selectLod(float pixels, int current) {
+    int level = 0;
+    for (int i = 0; i < kLodLevels - 1; ++i) {
+        // Boundaries move away from the side the object is currently on
+        float margin = (current >= 0 && current <= i) ? 1.0f - kLodHysteresis : 1.0f + kLodHysteresis;
+        if (current < 0) margin = 1.0f;
+        if (pixels < kLodPixels[i] * margin) level = i + 1;
+    }
+    return level;
+}
+
+float partDiameter(const Skeleton& skeleton, int part) {
+    AABB box = transformBounds(skeleton.partLocal[part], MeshRegistry::localBounds(skeleton.partMesh[part]));
+    return glm::length(box.max - box.min);
+}
@@ -4,54 +4,158 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
 
 #include "Shader.h"
 #include "camera.h"
 #include "scene.h"
 #include "robot.h"
+#include "robot_crowd.h"
+#include "job_system.h"
+#include "bench.h"
+#include "uniform_buffer.h"
+#include "simulation.h"
+#include "culling.h"
+#include "lod.h"
+#include "frame_arena.h"
+#include "alloc_counter.h"
+#include "render_queue.h"
+#include "indirect_renderer.h"
+#include "stream_buffer.h"
+#include "shader_cache.h"
+#include "shader_compiler.h"
+#include "shader_variants.h"
+#include "clustered_lights.h"
+#include "frame_capture.h"
+#include "input_log.h"
+#include "profiler.h"
 
 // Global constants and objects
 const unsigned int WIDTH = 1280;
 const unsigned int HEIGHT = 720;
 
-Camera gCamera(glm::vec3(0.0f, 1.0f, 4.0f));
 Scene  gScene;
 Robot  gRobot;
 
+// Optional instanced crowd (--crowd N) drawn instead of the single robot
+RobotCrowd gCrowd;
+
+// Worker threads for crowd animation and transform building
+JobSystem gJobs;
+
+// Fixed-timestep simulation (camera, robot, scene/camera mode) on its own thread
+Simulation gSim(120.0);
+
+// Frame-lifetime allocations (two arenas, alternate frames) and the sorted
+// draw queue that uses them
+FrameMemory gFrameMemory;
+RenderQueue gQueue;
+
+// Multi-draw indirect submission of the queue on GL 4.3+ contexts
+IndirectRenderer gIndirect;
+
+// Program binaries on disk and the background compiler that fills Shaders
+ShaderCache    gShaderCache;
+ShaderCompiler gShaderCompiler;
+
+// Shader sources; the mesh and indirect programs are built per permutation
+const std::string kShaderDir = "../resources/shaders/";
+const std::string kMeshVertex     = kShaderDir + "vertex_shader.glsl";
+const std::string kIndirectVertex = kShaderDir + "indirect_vertex_shader.glsl";
+const std::string kMeshFragment   = kShaderDir + "fragment_shader.glsl";
+const ProgramSource kStarProgram  = {kShaderDir + "star_vertex_shader.glsl", kShaderDir + "star_fragment_shader.glsl", ""};
+
+// Depth range of the projection (also the clustered lights' slice range)
+const float kZNear = 0.1f;
+const float kZFar  = 100.0f;
+
+// Optional recording of every rendered frame (--capture)
+FrameCapture gCapture;
+
+// Input log written with --record and played back with --replay. A replay
+// runs on a virtual clock and is deterministic: chunk streaming and shader
+// swaps wait for their workers, and capture never drops a frame.
+InputRecorder gRecorder;
+InputReplay   gReplay;
+bool          gDeterministic = false;
+const double  kReplayFrameSeconds = 1.0 / 60.0;
+
+// Startup clock: process start to first frame and to all programs ready
+std::chrono::steady_clock::time_point gStartTime;
+
+// Per-frame and material uniform blocks shared by all programs
+UniformBuffer<FrameConstants>    gFrameUBO;
+UniformBuffer<MaterialConstants> gMaterialUBO;
+
+// Scene point lights, assigned to view-space clusters every frame; with
+// --no-clustered the first kMaxPointLights go through FrameBlock instead
+ClusteredLights                 gLights;
+UniformBuffer<ClusterConstants> gClusterUBO;
+std::vector<PointLight>         gLightList;
+bool                            gClustered = true;
+
+// Mesh program permutation for a frame lit by pointLights lights
+std::uint32_t litKey(int pointLights) {
+    if (gClustered) return shaderKey(SHADER_LIGHTING | SHADER_CLUSTERED);
+    return shaderKey(SHADER_LIGHTING, std::min(pointLights, kMaxPointLights));
+}
+
 float lastX = WIDTH / 2.0f;
 float lastY = HEIGHT / 2.0f;
 bool  firstMouse = true;
 
-// Camera mode: 1 = free, 2 = orbit
-int   gCameraMode = 1;
+// Mouse motion gathered by the cursor callback until the next processInput
+float gMouseDX = 0.0f;
+float gMouseDY = 0.0f;
+
+// Trace file written on F12 and, if --trace was given, on exit
+std::string gTracePath = "trace.json";
+bool        gF12Down   = false;
 
-// Input processing
+// Input processing: sample keys and hand them to the simulation thread
 void processInput(GLFWwindow* window) {
+    PROFILE_SCOPE("processInput");
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    const float speed = 2.5f * 0.016f;
+    // Dump the profiler trace once per F12 press
+    bool f12 = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+    if (f12 && !gF12Down) PROFILE_WRITE_TRACE(gTracePath);
+    gF12Down = f12;
 
-    // Free camera movement (mode 1)
-    if (gCameraMode == 1) {
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) gCamera.processKeyboard(FORWARD,  speed);
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) gCamera.processKeyboard(BACKWARD, speed);
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) gCamera.processKeyboard(LEFT,     speed);
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) gCamera.processKeyboard(RIGHT,    speed);
-    }
+    InputState in;
+
+    // Free camera movement (applied in mode 1)
+    in.forward  = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    in.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    in.left     = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    in.right    = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
 
     // Robot arm control
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)    gRobot.raiseRightArm(+1.5f);
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)  gRobot.raiseRightArm(-1.5f);
+    in.armUp   = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+    in.armDown = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
 
     // Scene switching
-    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) gScene.setScene(1);
-    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) gScene.setScene(2);
-    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) gScene.setScene(3);
+    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) in.scene = 1;
+    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) in.scene = 2;
+    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) in.scene = 3;
 
     // Camera mode switching
-    if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS) gCameraMode = 1;
-    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) gCameraMode = 2;
+    if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS) in.cameraMode = 1;
+    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) in.cameraMode = 2;
+
+    // Mouse look (applied in mode 1)
+    in.mouseDX = gMouseDX;
+    in.mouseDY = gMouseDY;
+    gMouseDX = gMouseDY = 0.0f;
+
+    gSim.submitInput(in);
 }
 
 void mouse_callback(GLFWwindow*, double xpos, double ypos) {
@@ -60,19 +164,482 @@ void mouse_callback(GLFWwindow*, double xpos, double ypos) {
         lastY = (float)ypos;
         firstMouse = false;
     }
-    float xoffset = (float)xpos - lastX;
-    float yoffset = lastY - (float)ypos;
+    gMouseDX += (float)xpos - lastX;
+    gMouseDY += lastY - (float)ypos;
     lastX = (float)xpos;
     lastY = (float)ypos;
+}
+
+// Where every live run and replay starts
+SimState initialState() {
+    SimState initial;
+    initial.camera = Camera(glm::vec3(0.0f, 1.0f, 4.0f));
+    return initial;
+}
+
+// Render one frame of a simulation state
+// meshPrograms: vertex/fragment_shader permutations; indirectPrograms (may be
+// null): the same lighting over indirect_vertex_shader for the queue's MDI path
+void renderFrame(ShaderVariants& meshPrograms, ShaderVariants* indirectPrograms,
+                 Shader& starShader, const SimState& state) {
+    PROFILE_SCOPE("renderFrame");
+    PROFILE_GPU_SCOPE("frame");
+    float t = (float)state.time;
+    gFrameMemory.beginFrame();
+    gScene.setScene(state.scene);
+
+    // Robot animations
+    if (gCrowd.size() > 0) {
+        PROFILE_SCOPE("RobotCrowd::update");
+        gCrowd.update(t, gJobs);
+    } else {
+        gRobot.setState(state.robot);
+    }
+
+    // Set background color based on scene
+    glm::vec3 cc = gScene.clearColor();
+    glClearColor(cc.x, cc.y, cc.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Calculate View matrix based on camera mode
+    glm::mat4 view;
+
+    if (state.cameraMode == 1) {
+        // Free camera view
+        view = state.camera.viewMatrix();
+    } else {
+        // Orbit camera calculation
+        float orbitRadius = 4.0f;
+        float orbitHeight = 1.6f;
+        float orbitSpeed  = 0.4f;
+        float angle       = orbitSpeed * t;
+
+        glm::vec3 target(0.0f, 0.9f, 0.0f);
+        glm::vec3 eye(
+            target.x + orbitRadius * std::cos(angle),
+            target.y + orbitHeight,
+            target.z + orbitRadius * std::sin(angle)
+        );
+
+        view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    // Camera and lighting go to the GPU in a single buffer update
+    FrameConstants frame{};
+    frame.view          = view;
+    frame.proj          = glm::perspective(glm::radians(45.0f),
+                                           (float)WIDTH / (float)HEIGHT,
+                                           kZNear, kZFar);
+    frame.dirLightDir   = glm::normalize(glm::vec3(0.4f, 0.3f, 0.2f));
+    frame.dirLightColor = glm::vec3(1.0f, 0.65f, 0.25f);
+
+    gScene.gatherLights(t, gLightList);
+    if (gCrowd.size() == 0) gRobot.addEyeLights(gLightList);
+    if (gClustered) {
+        gClusterUBO.update(gLights.build(gLightList, view, frame.proj, kZNear, kZFar, WIDTH, HEIGHT, gJobs,
+                                         gFrameMemory.resource()));
+        gLights.bind();
+    } else {
+        for (int i = 0; i < (int)gLightList.size() && i < kMaxPointLights; ++i) {
+            frame.pointPos[i]   = view * glm::vec4(gLightList[i].position, 1.0f);
+            frame.pointColor[i] = glm::vec4(gLightList[i].color, 0.0f);
+        }
+    }
+    gFrameUBO.update(frame);
+
+    // The permutation matching this frame's lighting; nothing branches on it in the shaders
+    std::uint32_t lit     = litKey((int)gLightList.size());
+    Shader& shader        = meshPrograms.get(lit);
+    Shader& crowdShader   = meshPrograms.get(lit | SHADER_INSTANCED);
+    if (indirectPrograms) gQueue.useIndirect(&gIndirect, &indirectPrograms->get(lit));
+
+    // Everything outside the view frustum is dropped before any draw call
+    Frustum frustum(frame.proj * view);
+    LodView lod = makeLodView(view, frame.proj, HEIGHT);
+    if (gCrowd.size() > 0) {
+        PROFILE_SCOPE("RobotCrowd::cull");
+        gCrowd.cull(frustum, gJobs, lod);
+    }
+
+    // Queue scene and robot, then draw them sorted by state
+    gQueue.begin(gFrameMemory.current(), view);
+    {
+        PROFILE_SCOPE("Scene::draw");
+        gScene.draw(gQueue, shader, frustum);
+    }
+    if (gCrowd.size() == 0) {
+        PROFILE_SCOPE("Robot::draw");
+        gRobot.draw(gQueue, shader, frustum, lod);
+    }
+    {
+        PROFILE_SCOPE("RenderQueue::flush");
+        PROFILE_GPU_SCOPE("scene");
+        gQueue.flush();
+    }
+    {
+        PROFILE_SCOPE("Scene::drawStars");
+        PROFILE_GPU_SCOPE("stars");
+        gScene.drawStars(starShader, t);
+    }
+    {
+        PROFILE_SCOPE("Scene::drawVegetation");
+        PROFILE_GPU_SCOPE("vegetation");
+        gScene.drawVegetation(crowdShader, lod.eye, frustum, gFrameMemory.resource());
+        // Chunks requested now are uploaded next frame, whatever the worker's speed
+        if (gDeterministic) gScene.vegetation().waitIdle();
+    }
+
+    if (gCrowd.size() > 0) {
+        PROFILE_SCOPE("RobotCrowd::draw");
+        PROFILE_GPU_SCOPE("crowd");
+        crowdShader.use();
+        gCrowd.draw();
+    }
+}
+
+// Flush the recording (--capture) and say what made it to disk
+void stopCapture() {
+    if (!gCapture.active()) return;
+    gCapture.stop();
+    CaptureStats cs = gCapture.stats();
+    std::cout << "Captured " << cs.written << " of " << cs.frames << " frames ("
+              << cs.droppedReadback << " dropped waiting for the GPU, "
+              << cs.droppedQueue << " with the encoders busy)\n";
+}
+
+// Culling counters of the last frame; a crowd robot counts as one drawable
+CullStats frameCullStats() {
+    CullStats stats = gScene.cullStats();
+    stats.add(gCrowd.size() > 0 ? gCrowd.cullStats() : gRobot.cullStats());
+    return stats;
+}
+
+// Parts (crowd: robots) and triangles per LOD level of the last frame
+const LodStats& frameLodStats() {
+    return gCrowd.size() > 0 ? gCrowd.lodStats() : gRobot.lodStats();
+}
+
+// Benchmarks that need no context (submission goes to a recording device);
+// false if the submission or vegetation checks failed
+static bool benchCpuSections(BenchReport& report, int frames) {
+    benchForwardKinematics(report, 10000, 50);
+    benchJobScaling(report, 10000, 20);
+    benchCulling(report, 10000, 20);
+    bool vegetationOk = benchVegetationDeterminism(report);
+    return benchSubmission(report, 100, frames) && vegetationOk;
+}
+
+// Headless benchmark: fixed frame count per scene and camera mode, stats as JSON
+int runBench(ShaderVariants& meshPrograms, ShaderVariants* indirectPrograms, Shader& starShader,
+             int frames, bool replay, const std::string& outPath) {
+    OffscreenTarget target;
+    if (!target.init(WIDTH, HEIGHT)) return -1;
+    target.bind();
+    glViewport(0, 0, WIDTH, HEIGHT);
+
+    GpuTimer gpuTimer;
+    gpuTimer.init();
+    BenchReport report;
+
+    // Startup as this run saw it (warm if an earlier run filled the cache)
+    double fallbackMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gStartTime).count();
+    gShaderCompiler.waitIdle();
+    gShaderCompiler.poll();
+    double readyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gStartTime).count();
+    ShaderCacheStats cacheStats = gShaderCache.stats();
+    report.addMetric("startup_fallback_ready_ms", fallbackMs);
+    report.addMetric("startup_shaders_ready_ms", readyMs);
+    report.addMetric("startup_shader_cache_hits", cacheStats.hits);
+    report.addMetric("startup_shader_cache_misses", cacheStats.misses);
+
+    // Cold (empty cache) vs. warm (binaries on disk) build of every program the frames use
+    std::uint32_t lit = litKey(1);
+    std::vector<ProgramSource> programs = {meshPrograms.source(lit),
+                                           meshPrograms.source(lit | SHADER_INSTANCED),
+                                           kStarProgram};
+    if (indirectPrograms) programs.push_back(indirectPrograms->source(lit));
+    benchShaderCache(report, programs);
+
+    bool checksPassed = benchCpuSections(report, frames);
+
+    // Render `frames` measured frames of a scene/camera mode after a warmup;
+    // frameAllocs is the render thread's heap allocations per measured frame
+    const int warmup = 10;
+    double frameAllocs = 0.0;
+    auto measure = [&](int scene, int mode, std::vector<double>& cpuMs, std::vector<double>& gpuMs) {
+        SimState state;
+        state.camera     = Camera(glm::vec3(0.0f, 1.0f, 4.0f));
+        state.scene      = scene;
+        state.cameraMode = mode;
+
+        cpuMs.reserve(frames);
+        gpuMs.reserve(frames);
+        std::uint64_t allocs = 0;
+
+        for (int i = 0; i < warmup + frames; ++i) {
+            // Fixed 60 Hz steps with no input so every run animates identically
+            stepSimulation(state, InputState(), 1.0f / 60.0f);
+            bool measured = i >= warmup;
+
+            std::uint64_t allocsBefore = threadAllocations();
+            auto start = std::chrono::steady_clock::now();
+            if (measured) gpuTimer.begin();
+            renderFrame(meshPrograms, indirectPrograms, starShader, state);
+            gCapture.capture();
+            if (measured) gpuTimer.end();
+            glFlush();
+            PROFILE_END_FRAME();
+            auto stop = std::chrono::steady_clock::now();
+            if (measured) allocs += threadAllocations() - allocsBefore;
+
+            if (measured) {
+                cpuMs.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+                gpuTimer.collect(gpuMs);
+            }
+        }
+        gpuTimer.collect(gpuMs, true);
+        frameAllocs = frames > 0 ? (double)allocs / frames : 0.0;
+    };
+
+    for (int scene = 1; scene <= 3; ++scene) {
+        for (int mode = 1; mode <= 2; ++mode) {
+            std::vector<double> cpuMs, gpuMs;
+            measure(scene, mode, cpuMs, gpuMs);
+
+            std::string name = "scene" + std::to_string(scene) +
+                               (mode == 1 ? "_free" : "_orbit");
+            report.addCase(name, cpuMs, gpuMs);
+
+            CullStats cull = frameCullStats();
+            report.addMetric(name + "_visible", cull.visible);
+            report.addMetric(name + "_culled", cull.culled);
+            report.addMetric(name + "_allocs_per_frame", frameAllocs);
+
+            const LodStats& lod = frameLodStats();
+            for (int level = 0; level < kLodLevels; ++level) {
+                std::string key = name + "_lod" + std::to_string(level);
+                report.addMetric(key + "_instances", lod.instances[level]);
+                report.addMetric(key + "_triangles", (double)lod.triangles[level]);
+            }
+
+            const RenderStats& rs = gQueue.stats();
+            report.addMetric(name + "_packets", rs.packets);
+            report.addMetric(name + "_draw_calls", rs.drawCalls);
+            report.addMetric(name + "_program_changes", rs.programChanges);
+            report.addMetric(name + "_vao_changes", rs.vaoChanges);
+            report.addMetric(name + "_material_changes", rs.materialChanges);
+            report.addMetric(name + "_unsorted_vao_changes", rs.unsortedVaoChanges);
+            report.addMetric(name + "_unsorted_material_changes", rs.unsortedMaterialChanges);
+
+            if (scene == 3) {
+                const VegetationStats& veg = gScene.vegetation().stats();
+                report.addMetric(name + "_vegetation_instances", (double)veg.instances);
+                report.addMetric(name + "_vegetation_draw_calls", veg.drawCalls);
+                report.addMetric(name + "_vegetation_chunks", veg.visibleChunks);
+            }
+        }
+    }
+
+    // The --replay session on its virtual clock: the same frames every run, so
+    // builds can be compared on it; the checksum covers every rendered state
+    if (replay) {
+        gDeterministic = true;
+        gReplay.start(initialState());
+        std::vector<double> cpuMs, gpuMs;
+        std::uint64_t checksum = 1469598103934665603ull;
+        while (!gReplay.finished()) {
+            SimState state = gReplay.frame(kReplayFrameSeconds);
+            gShaderCompiler.waitIdle();
+            gShaderCompiler.poll();
+
+            auto start = std::chrono::steady_clock::now();
+            gpuTimer.begin();
+            renderFrame(meshPrograms, indirectPrograms, starShader, state);
+            gCapture.capture();
+            gpuTimer.end();
+            glFlush();
+            PROFILE_END_FRAME();
+            cpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            gpuTimer.collect(gpuMs);
+
+            glm::mat4 view = state.camera.viewMatrix();
+            const unsigned char* bytes[2] = {(const unsigned char*)&view, (const unsigned char*)&state.robot};
+            const size_t sizes[2] = {sizeof(view), sizeof(state.robot)};
+            for (int k = 0; k < 2; ++k)
+                for (size_t i = 0; i < sizes[k]; ++i) checksum = (checksum ^ bytes[k][i]) * 1099511628211ull;
+            checksum = (checksum ^ (std::uint64_t)(state.scene * 4 + state.cameraMode)) * 1099511628211ull;
+        }
+        gpuTimer.collect(gpuMs, true);
+        gDeterministic = false;
+
+        report.addCase("replay", cpuMs, gpuMs);
+        report.addMetric("replay_steps", (double)gReplay.steps());
+        report.addMetric("replay_frames", (double)gReplay.frames());
+        report.addMetric("replay_checksum", (double)(checksum & ((1ull << 52) - 1)));
+    }
 
-    // Mouse look only in free camera mode
-    if (gCameraMode == 1) {
-        gCamera.processMouse(xoffset, yoffset);
+    report.addMetric("stars", gScene.starCount());
+
+    // Jungle orbit lit by growing numbers of point lights
+    report.addMetric("clustered_lighting", gClustered ? 1 : 0);
+    for (int lights : {1, 64, 256, 1024}) {
+        gScene.setLightCount(lights);
+        std::vector<double> cpuMs, gpuMs;
+        measure(3, 2, cpuMs, gpuMs);
+
+        std::string name = "lights" + std::to_string(lights);
+        report.addCase(name, cpuMs, gpuMs);
+        const ClusterStats& cs = gLights.stats();
+        report.addMetric(name + "_visible", cs.visibleLights);
+        report.addMetric(name + "_cluster_indices", cs.indices);
+        report.addMetric(name + "_max_per_cluster", cs.maxPerCluster);
+        report.addMetric(name + "_cluster_build_ms", cs.buildMs);
+        report.addMetric(name + "_allocs_per_frame", frameAllocs);
     }
+    gScene.setLightCount(-1);
+
+    // Recording cost on the render thread, and frames the capture had to drop
+    // (skipped when --capture already records the whole run)
+    for (CaptureFormat format : {CaptureFormat::PNG, CaptureFormat::Y4M}) {
+        if (gCapture.active()) break;
+        std::string name = format == CaptureFormat::PNG ? "capture_png" : "capture_y4m";
+        CaptureSettings settings;
+        settings.path   = format == CaptureFormat::PNG ? "capture_bench" : "capture_bench.y4m";
+        settings.format = format;
+        if (!gCapture.start(WIDTH, HEIGHT, settings)) continue;
+
+        std::vector<double> cpuMs, gpuMs;
+        measure(1, 2, cpuMs, gpuMs);
+        gCapture.stop();
+        report.addCase(name, cpuMs, gpuMs);
+
+        CaptureStats cs = gCapture.stats();
+        report.addMetric(name + "_written", cs.written);
+        report.addMetric(name + "_dropped_readback", cs.droppedReadback);
+        report.addMetric(name + "_dropped_queue", cs.droppedQueue);
+        report.addMetric(name + "_capture_ms_mean", cs.frames ? cs.captureMsTotal / cs.frames : 0.0);
+        report.addMetric(name + "_capture_ms_max", cs.captureMsMax);
+        report.addMetric(name + "_encode_ms_mean", cs.written ? cs.encodeMsTotal / cs.written : 0.0);
+
+        std::error_code ec;
+        std::filesystem::remove_all(settings.path, ec);
+    }
+    report.addMetric("shader_variants", meshPrograms.count() + (indirectPrograms ? indirectPrograms->count() : 0));
+
+    // Jungle chunks generated while the scene 3 cases ran
+    const VegetationStats& veg = gScene.vegetation().stats();
+    report.addMetric("vegetation_chunks_generated", veg.generatedChunks);
+    report.addMetric("vegetation_chunk_ms_mean", veg.generatedChunks ? veg.generateMsTotal / veg.generatedChunks : 0.0);
+    report.addMetric("vegetation_chunk_ms_max", veg.generateMsMax);
+    report.addMetric("vegetation_resident_chunks", veg.residentChunks);
+    report.addMetric("vegetation_resident_bytes", (double)veg.residentBytes);
+    benchVegetationStreaming(report, 400);
+    report.addMetric("multi_draw_indirect", gQueue.indirect() ? 1 : 0);
+
+    // Every static mesh lives in one vertex + one index buffer
+    report.addMetric("geometry_meshes", meshRegistry().meshCount());
+    report.addMetric("geometry_used_bytes", (double)meshRegistry().usedBytes());
+    report.addMetric("geometry_capacity_bytes", (double)meshRegistry().capacityBytes());
+
+    // Both frame arenas, grown to the largest frame so far
+    report.addMetric("frame_arena_bytes", (double)gFrameMemory.capacity());
+
+    if (gCrowd.size() > 0) {
+        report.addMetric("crowd_robots", gCrowd.size());
+        report.addMetric("crowd_draw_calls", gCrowd.drawCalls());
+        report.addMetric("crowd_upload_stalls", gCrowd.uploadStalls());
+    }
+
+    // Vertex stage of a dense sphere grid: per-vertex inverse() (the old
+    // path) against the normal matrix built once per draw on the CPU
+    {
+        Shader& perVertex = meshPrograms.get(shaderKey(SHADER_LIGHTING | SHADER_VERTEX_INVERSE));
+        Shader& perDraw   = meshPrograms.get(shaderKey(SHADER_LIGHTING));
+        gShaderCompiler.waitIdle();
+        gShaderCompiler.poll();
+
+        FrameConstants frame{};
+        frame.view          = glm::lookAt(glm::vec3(0.0f, 1.0f, 4.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+                                          glm::vec3(0.0f, 1.0f, 0.0f));
+        frame.proj          = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT,
+                                               kZNear, kZFar);
+        frame.dirLightDir   = glm::normalize(glm::vec3(0.4f, 0.3f, 0.2f));
+        frame.dirLightColor = glm::vec3(1.0f, 0.65f, 0.25f);
+        gFrameUBO.update(frame);
+        benchVertexTransforms(report, perVertex, perDraw, frame.view, 400, 100);
+    }
+
+    // Per-frame instance upload: crowd-sized matrices, old pattern vs. ring buffer
+    benchStreamUpload(report, meshPrograms.get(lit).ID, 10000 * robotSkeleton().partCount(), sizeof(InstanceData), 200);
+
+    // Frames whose GPU timing had to wait for an older query to finish
+    report.addMetric("gpu_timer_stalls", gpuTimer.stalls());
+    gpuTimer.destroy();
+    target.destroy();
+    return report.write(outPath) && checksPassed ? 0 : -1;
 }
 
 // Main program entry
-int main() {
+int main(int argc, char** argv) {
+    gStartTime = std::chrono::steady_clock::now();
+
+    // Command line: [--crowd N] [--stars N] [--lights N] [--no-indirect] [--no-clustered]
+    //               [--no-shader-cache] [--capture dir|file.y4m] [--record file | --replay file]
+    //               [--trace file.json]
+    //               [--bench | --bench-cpu [--frames N] [--out file.json]]
+    bool        bench       = false;
+    bool        benchCpu    = false;
+    bool        indirect    = true;
+    bool        shaderCache = true;
+    bool        traceOnExit = false;
+    int         benchFrames = 300;
+    int         crowdSize   = 0;
+    int         starCount   = -1;   // scene default
+    int         lightCount  = -1;   // scene default
+    std::string benchOut;
+    std::string capturePath;
+    std::string recordPath;
+    std::string replayPath;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0) bench = true;
+        else if (std::strcmp(argv[i], "--bench-cpu") == 0) benchCpu = true;
+        else if (std::strcmp(argv[i], "--crowd") == 0 && i + 1 < argc) crowdSize = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--stars") == 0 && i + 1 < argc) starCount = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc) lightCount = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--no-indirect") == 0) indirect = false;
+        else if (std::strcmp(argv[i], "--no-clustered") == 0) gClustered = false;
+        else if (std::strcmp(argv[i], "--no-shader-cache") == 0) shaderCache = false;
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePath = argv[++i];
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) benchFrames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) benchOut = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            gTracePath  = argv[++i];
+            traceOnExit = true;
+        }
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--crowd N] [--stars N] [--lights N] [--no-indirect] [--no-clustered] [--no-shader-cache]"
+                         " [--capture dir|file.y4m] [--record file | --replay file] [--trace file.json]"
+                         " [--bench | --bench-cpu [--frames N] [--out file.json]]\n";
+            return -1;
+        }
+    }
+
+    // CPU sections only: no window, no context, no GL library calls
+    if (benchCpu) {
+        BenchReport report;
+        bool checksPassed = benchCpuSections(report, benchFrames);
+        return report.write(benchOut) && checksPassed ? 0 : -1;
+    }
+
+    bool replaying = !replayPath.empty();
+    if (replaying && !gReplay.load(replayPath)) return -1;
+
+    // Benchmarks need no display: null platform + OSMesa software context
+    if (bench) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+
     if (!glfwInit()) {
         std::cerr << "Failed to init GLFW\n";
         return -1;
@@ -80,6 +647,10 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_DEBUG, 1);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (bench) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
     GLFWwindow* window = glfwCreateWindow(
         WIDTH, HEIGHT,
@@ -102,80 +673,153 @@ int main() {
     glfwSetCursorPosCallback(window, mouse_callback);
     glEnable(GL_DEPTH_TEST);
 
-    Shader shader("../resources/shaders/vertex_shader.glsl",
-                  "../resources/shaders/fragment_shader.glsl");
+    PROFILE_THREAD_NAME("main");
+    PROFILE_INIT_GPU();
+
+    // Lit permutations are built on a hidden context sharing with the window;
+    // until they arrive each draws with its UNLIT sibling
+    gShaderCache.setEnabled(shaderCache);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* compileContext = glfwCreateWindow(1, 1, "shader compiler", nullptr, window);
+    gShaderCompiler.start(compileContext, gShaderCache);
+
+    ShaderVariants meshPrograms(kMeshVertex, kMeshFragment, gShaderCache, &gShaderCompiler);
+    meshPrograms.bindUniformBlock("FrameBlock", FRAME_BINDING);
+    meshPrograms.bindUniformBlock("MaterialBlock", MATERIAL_BINDING);
+    meshPrograms.bindUniformBlock("ClusterBlock", CLUSTER_BINDING);
+    meshPrograms.bindSampler("uLightData", LIGHT_DATA_UNIT);
+    meshPrograms.bindSampler("uLightGrid", LIGHT_GRID_UNIT);
+    meshPrograms.bindSampler("uLightIndices", LIGHT_INDEX_UNIT);
+    std::uint32_t lit = litKey(1);
+    meshPrograms.get(lit);
+    meshPrograms.get(lit | SHADER_INSTANCED);
+
+    // Stars never light anything: one small program, built now
+    Shader starShader(gShaderCache.build(kStarProgram));
+    starShader.bindUniformBlock("FrameBlock", FRAME_BINDING);
+
+    // Persistent-mapped streaming on GL 4.4+, orphaning otherwise
+    StreamBuffer::loadEntryPoints((GLADloadproc)glfwGetProcAddress);
+
+    // Whole-frame multi-draw when the context has it, per-draw calls otherwise
+    std::unique_ptr<ShaderVariants> indirectPrograms;
+    if (indirect && gIndirect.init((GLADloadproc)glfwGetProcAddress)) {
+        // Built now (no compiler): whether it links decides the submission path
+        indirectPrograms.reset(new ShaderVariants(kIndirectVertex, kMeshFragment, gShaderCache));
+        indirectPrograms->bindUniformBlock("FrameBlock", FRAME_BINDING);
+        indirectPrograms->bindUniformBlock("MaterialBlock", MATERIAL_BINDING);
+        indirectPrograms->bindUniformBlock("ClusterBlock", CLUSTER_BINDING);
+        indirectPrograms->bindSampler("uLightData", LIGHT_DATA_UNIT);
+        indirectPrograms->bindSampler("uLightGrid", LIGHT_GRID_UNIT);
+        indirectPrograms->bindSampler("uLightIndices", LIGHT_INDEX_UNIT);
+        if (indirectPrograms->get(lit).ID) {
+            gQueue.useIndirect(&gIndirect, &indirectPrograms->get(lit));
+        } else {
+            indirectPrograms.reset();
+            gIndirect.destroy();
+        }
+    }
+
+    gFrameUBO.init(FRAME_BINDING);
+    gMaterialUBO.init(MATERIAL_BINDING);
+    gClusterUBO.init(CLUSTER_BINDING);
+    gMaterialUBO.update({glm::vec3(0.18f, 0.18f, 0.18f), 64.0f});
 
     gScene.ensureGround();
+    if (starCount >= 0) gScene.setStarCount(starCount);
+    gScene.setLightCount(lightCount);
     gScene.setScene(1);
     gRobot.initGPU();
+    if (crowdSize > 0) {
+        gCrowd.init(crowdSize);
+        gCrowd.initGPU();
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        processInput(window);
-
-        // Get current time for animations
-        float t = static_cast<float>(glfwGetTime());
-
-        // Robot animations
-        gRobot.animateHead(t);
-        gRobot.animateLegs(t);
-
-        // Set background color based on scene
-        glm::vec3 cc = gScene.clearColor();
-        glClearColor(cc.x, cc.y, cc.z, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        shader.use();
+    if (!capturePath.empty()) {
+        CaptureSettings settings;
+        settings.path   = capturePath;
+        settings.format = FrameCapture::formatFor(capturePath);
+        settings.lossless = replaying;
+        gCapture.start(WIDTH, HEIGHT, settings);
+    }
 
-        // Calculate View matrix based on camera mode
-        glm::mat4 view;
+    if (bench) {
+        int rc = runBench(meshPrograms, indirectPrograms.get(), starShader, benchFrames, replaying, benchOut);
+        stopCapture();
+        gShaderCompiler.stop();
+        meshPrograms.destroy();
+        if (indirectPrograms) indirectPrograms->destroy();
+        if (traceOnExit) PROFILE_WRITE_TRACE(gTracePath);
+        PROFILE_SHUTDOWN_GPU();
+        gFrameUBO.destroy();
+        gMaterialUBO.destroy();
+        gClusterUBO.destroy();
+        gLights.destroy();
+        gCrowd.destroyGPU();
+        gIndirect.destroy();
+        gScene.destroyGPU();
+        meshRegistry().destroy();
+        glfwTerminate();
+        return rc;
+    }
 
-        if (gCameraMode == 1) {
-            // Free camera view
-            view = gCamera.viewMatrix();
-        } else {
-            // Orbit camera calculation
-            float orbitRadius = 4.0f;
-            float orbitHeight = 1.6f;
-            float orbitSpeed  = 0.4f;
-            float angle       = orbitSpeed * t;
-
-            glm::vec3 target(0.0f, 0.9f, 0.0f);
-            glm::vec3 eye(
-                target.x + orbitRadius * std::cos(angle),
-                target.y + orbitHeight,
-                target.z + orbitRadius * std::sin(angle)
-            );
-
-            view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+    if (replaying) {
+        gDeterministic = true;
+        gReplay.start(initialState());
+    } else {
+        if (!recordPath.empty()) {
+            gRecorder.begin(gSim.rate());
+            gSim.setRecorder(&gRecorder);
         }
+        gSim.start(initialState());
+    }
 
-        // Projection matrix
-        glm::mat4 proj = glm::perspective(glm::radians(45.0f),
-                                          (float)WIDTH / (float)HEIGHT,
-                                          0.1f, 100.0f);
-        shader.setMat4("uView", view);
-        shader.setMat4("uProj", proj);
-
-        // Lighting setup
-        shader.setInt("uUseLight", 1);
-        shader.setVec3("uAmbient",    glm::vec3(0.18f, 0.18f, 0.18f));
-        shader.setFloat("uShininess", 64.0f);
-        shader.setVec3("uDirLightDir",   glm::normalize(glm::vec3(0.4f, 0.3f, 0.2f)));
-        shader.setVec3("uDirLightColor", glm::vec3(1.0f, 0.65f, 0.25f));
-        shader.setVec3("uPointPos",      glm::vec3(0.0f, 1.2f, 0.0f));
-        shader.setVec3("uPointColor",    glm::vec3(0.2f, 0.6f, 1.0f));
+    while (!glfwWindowShouldClose(window)) {
+        processInput(window);
 
-        // Draw robot and scene
-        gRobot.setBaseRotation(0.0f);
+        // Swap in programs the background compiler has finished
+        if (gDeterministic) gShaderCompiler.waitIdle();
+        if (gShaderCompiler.pending() > 0) gShaderCompiler.poll();
 
-        gScene.draw(shader);
-        gRobot.draw(shader);
+        // Interpolated between the two newest simulation steps (of the log when replaying)
+        SimState state = replaying ? gReplay.frame(kReplayFrameSeconds) : gSim.sample();
+        renderFrame(meshPrograms, indirectPrograms.get(), starShader, state);
+        gCapture.capture();
+        if (replaying && gReplay.finished()) glfwSetWindowShouldClose(window, true);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            PROFILE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
+        PROFILE_END_FRAME();
     }
-
-    gRobot.destroyGPU();
+    gSim.stop();
+    if (replaying) {
+        std::cout << "Replayed " << gReplay.steps() << " steps in " << gReplay.frames() << " frames\n";
+    } else if (gRecorder.recording() && gRecorder.save(recordPath)) {
+        std::cout << "Recorded " << gRecorder.steps() << " steps (" << gRecorder.bytes()
+                  << " bytes of input) to " << recordPath << "\n";
+    }
+    stopCapture();
+    gShaderCompiler.stop();
+    meshPrograms.destroy();
+    if (indirectPrograms) indirectPrograms->destroy();
+
+    if (traceOnExit) PROFILE_WRITE_TRACE(gTracePath);
+    PROFILE_SHUTDOWN_GPU();
+
+    gFrameUBO.destroy();
+    gMaterialUBO.destroy();
+    gClusterUBO.destroy();
+    gLights.destroy();
+    gCrowd.destroyGPU();
+    gIndirect.destroy();
+    gScene.destroyGPU();
+    meshRegistry().destroy();
     glfwTerminate();
     return 0;
-}
\ No newline at end of file
+}
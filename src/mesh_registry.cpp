@@ -0,0 +1,266 @@
+#include "mesh_registry.h"
+#include "render_device.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+MeshRegistry& meshRegistry() {
+    static MeshRegistry registry;
+    return registry;
+}
+
+MeshRegistry::MeshRegistry()
+    : vao(0), vbo(0), ebo(0),
+      vertexCapacity(0), indexCapacity(0),
+      vertexCount(0), indexCount(0), meshesAdded(0) {}
+
+std::uint64_t MeshRegistry::key(Primitive type, int tessellation) {
+    return (std::uint64_t(type) << 32) | std::uint32_t(tessellation);
+}
+
+// Attribute 0 = position, attribute 1 = normal
+static void setVertexLayout(RenderDevice& device) {
+    device.vertexAttribute(0, 3, sizeof(MeshVertex), offsetof(MeshVertex, position));
+    device.vertexAttribute(1, 3, sizeof(MeshVertex), offsetof(MeshVertex, normal));
+}
+
+void MeshRegistry::init(GLsizei vertices, GLsizei indices) {
+    if (vao) return;
+    vertexCapacity = vertices;
+    indexCapacity  = indices;
+
+    RenderDevice& device = renderDevice();
+    vbo = device.createBuffer();
+    ebo = device.createBuffer();
+    vao = makeVertexArray();
+    device.bufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCapacity * sizeof(MeshVertex), nullptr, GL_STATIC_DRAW);
+    device.bufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    device.bindVertexArray(0);
+    device.bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Delete the shared buffers
+void MeshRegistry::destroy() {
+    RenderDevice& device = renderDevice();
+    if (ebo) device.deleteBuffer(ebo);
+    if (vbo) device.deleteBuffer(vbo);
+    if (vao) device.deleteVertexArray(vao);
+    vao = vbo = ebo = 0;
+    vertexCount = indexCount = 0;
+    meshesAdded = 0;
+    meshes.clear();
+}
+
+GLuint MeshRegistry::makeVertexArray() const {
+    RenderDevice& device = renderDevice();
+    GLuint array = device.createVertexArray();
+    device.bindVertexArray(array);
+    device.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    device.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    setVertexLayout(device);
+    return array;   // left bound so the caller can add attributes
+}
+
+Mesh MeshRegistry::add(const std::vector<MeshVertex>& vertices, const std::vector<GLuint>& indices,
+                       GLenum mode) {
+    init();
+    if (vertexCount + (GLsizei)vertices.size() > vertexCapacity ||
+        indexCount + (GLsizei)indices.size() > indexCapacity) {
+        std::cerr << "MeshRegistry: geometry buffers full, mesh dropped\n";
+        return Mesh();
+    }
+
+    Mesh m;
+    m.vao        = vao;
+    m.mode       = mode;
+    m.count      = (GLsizei)indices.size();
+    m.firstIndex = (GLuint)indexCount;
+    m.baseVertex = vertexCount;
+
+    RenderDevice& device = renderDevice();
+    device.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    device.bufferSubData(GL_ARRAY_BUFFER, (GLintptr)vertexCount * sizeof(MeshVertex),
+                         vertices.size() * sizeof(MeshVertex), vertices.data());
+    device.bindBuffer(GL_ARRAY_BUFFER, 0);
+    // The element buffer binding is VAO state: go through the VAO
+    device.bindVertexArray(vao);
+    device.bufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)indexCount * sizeof(GLuint),
+                         indices.size() * sizeof(GLuint), indices.data());
+    device.bindVertexArray(0);
+
+    vertexCount += (GLsizei)vertices.size();
+    indexCount  += (GLsizei)indices.size();
+    ++meshesAdded;
+    return m;
+}
+
+std::size_t MeshRegistry::usedBytes() const {
+    return (std::size_t)vertexCount * sizeof(MeshVertex) + (std::size_t)indexCount * sizeof(GLuint);
+}
+
+std::size_t MeshRegistry::capacityBytes() const {
+    return (std::size_t)vertexCapacity * sizeof(MeshVertex) + (std::size_t)indexCapacity * sizeof(GLuint);
+}
+
+GLsizei MeshRegistry::triangleCount(const Mesh& mesh) {
+    return mesh.mode == GL_TRIANGLES ? mesh.count / 3 : 0;
+}
+
+void MeshRegistry::draw(const Mesh& mesh) {
+    RenderDevice& device = renderDevice();
+    device.bindVertexArray(mesh.vao);
+    device.drawElements(mesh.mode, mesh.count, mesh.firstIndex, mesh.baseVertex);
+    device.bindVertexArray(0);
+}
+
+void MeshRegistry::drawInstanced(const Mesh& mesh, GLuint array, GLsizei instances) {
+    RenderDevice& device = renderDevice();
+    device.bindVertexArray(array);
+    device.drawElementsInstanced(mesh.mode, mesh.count, mesh.firstIndex, instances, mesh.baseVertex);
+    device.bindVertexArray(0);
+}
+
+// ------------------------------------------------
+// Primitive generators (indexed triangle lists)
+// ------------------------------------------------
+struct Geometry {
+    std::vector<MeshVertex> vertices;
+    std::vector<GLuint>     indices;
+};
+
+// Cube with per-face normals (24 vertices)
+static Geometry buildCube() {
+    const float h = 0.5f;
+    const glm::vec3 normals[6] = {{1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}};
+    Geometry g;
+    for (const glm::vec3& n : normals) {
+        // Two axes spanning the face, ordered so the winding faces outward
+        glm::vec3 u(n.y, n.z, n.x);
+        glm::vec3 v = glm::cross(n, u);
+        GLuint base = (GLuint)g.vertices.size();
+        g.vertices.push_back({(n - u - v) * h, n});
+        g.vertices.push_back({(n + u - v) * h, n});
+        g.vertices.push_back({(n + u + v) * h, n});
+        g.vertices.push_back({(n - u + v) * h, n});
+        g.indices.insert(g.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+    return g;
+}
+
+// Unit sphere; stacks follow slices at the original 16:24 ratio
+static Geometry buildSphere(int slices) {
+    const int stacks = slices * 2 / 3;
+    Geometry g;
+    g.vertices.reserve((stacks + 1) * (slices + 1));
+    for (int i = 0; i <= stacks; ++i) {
+        float V = i / (float)stacks;
+        float phi = V * M_PI;
+        for (int j = 0; j <= slices; ++j) {
+            float U = j / (float)slices;
+            float theta = U * (M_PI * 2);
+            glm::vec3 p(cos(theta) * sin(phi), cos(phi), sin(theta) * sin(phi));
+            g.vertices.push_back({p, p});
+        }
+    }
+
+    g.indices.reserve(stacks * slices * 6);
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < slices; ++j) {
+            GLuint first = (i * (slices + 1)) + j;
+            GLuint second = first + slices + 1;
+            g.indices.insert(g.indices.end(), {
+                first, second, first + 1,
+                second, second + 1, first + 1
+            });
+        }
+    }
+    return g;
+}
+
+// Open cylinder side with radial normals
+static Geometry buildTube(int segments) {
+    Geometry g;
+    for (int i = 0; i <= segments; ++i) {
+        float angle = i * 2.0f * M_PI / segments;
+        glm::vec3 n(cos(angle), sin(angle), 0.0f);
+        g.vertices.push_back({glm::vec3(n.x, n.y,  0.5f), n});
+        g.vertices.push_back({glm::vec3(n.x, n.y, -0.5f), n});
+    }
+    for (int i = 0; i < segments; ++i) {
+        GLuint a = 2 * i;
+        g.indices.insert(g.indices.end(), {a, a + 1, a + 2, a + 1, a + 3, a + 2});
+    }
+    return g;
+}
+
+// Cylinder cap: centre plus a ring, facing +Z
+static Geometry buildDisc(int segments) {
+    const glm::vec3 n(0.0f, 0.0f, 1.0f);
+    Geometry g;
+    g.vertices.push_back({glm::vec3(0.0f), n});
+    for (int i = 0; i <= segments; ++i) {
+        float angle = i * 2.0f * M_PI / segments;
+        g.vertices.push_back({glm::vec3(cos(angle), sin(angle), 0.0f), n});
+    }
+    for (int i = 1; i <= segments; ++i)
+        g.indices.insert(g.indices.end(), {0u, (GLuint)i, (GLuint)i + 1});
+    return g;
+}
+
+// Square pyramid with flat-shaded faces
+static Geometry buildPyramid() {
+    const glm::vec3 p[5] = {{-1,0,-1}, {1,0,-1}, {1,0,1}, {-1,0,1}, {0,1,0}};
+    const int faces[6][3] = {{0,1,2}, {0,2,3}, {0,1,4}, {1,2,4}, {2,3,4}, {3,0,4}};
+    const glm::vec3 centre(0.0f, 0.25f, 0.0f);
+    Geometry g;
+    for (const auto& f : faces) {
+        glm::vec3 n = glm::normalize(glm::cross(p[f[1]] - p[f[0]], p[f[2]] - p[f[0]]));
+        glm::vec3 mid = (p[f[0]] + p[f[1]] + p[f[2]]) / 3.0f;
+        if (glm::dot(n, mid - centre) < 0.0f) n = -n;
+        GLuint base = (GLuint)g.vertices.size();
+        for (int k = 0; k < 3; ++k) g.vertices.push_back({p[f[k]], n});
+        g.indices.insert(g.indices.end(), {base, base + 1, base + 2});
+    }
+    return g;
+}
+
+// Ground quad facing +Y
+static Geometry buildQuad() {
+    const glm::vec3 n(0.0f, 1.0f, 0.0f);
+    Geometry g;
+    g.vertices = {{{-1,0,-1}, n}, {{1,0,-1}, n}, {{1,0,1}, n}, {{-1,0,1}, n}};
+    g.indices  = {0, 1, 2, 0, 2, 3};
+    return g;
+}
+
+static Geometry buildPrimitive(Primitive type, int tessellation) {
+    switch (type) {
+    case Primitive::Cube:    return buildCube();
+    case Primitive::Sphere:  return buildSphere(tessellation);
+    case Primitive::Tube:    return buildTube(tessellation);
+    case Primitive::Disc:    return buildDisc(tessellation);
+    case Primitive::Pyramid: return buildPyramid();
+    case Primitive::Quad:    return buildQuad();
+    }
+    return Geometry();
+}
+
+const Mesh& MeshRegistry::get(Primitive type, int tessellation) {
+    auto it = meshes.find(key(type, tessellation));
+    if (it != meshes.end()) return it->second;
+    Geometry g = buildPrimitive(type, tessellation);
+    return meshes.emplace(key(type, tessellation), add(g.vertices, g.indices, GL_TRIANGLES)).first->second;
+}
+
+AABB MeshRegistry::localBounds(Primitive type) {
+    AABB b;
+    switch (type) {
+    case Primitive::Cube:    b.min = glm::vec3(-0.5f);              b.max = glm::vec3(0.5f);             break;
+    case Primitive::Sphere:  b.min = glm::vec3(-1.0f);              b.max = glm::vec3(1.0f);             break;
+    case Primitive::Tube:    b.min = glm::vec3(-1.0f, -1.0f, -0.5f); b.max = glm::vec3(1.0f, 1.0f, 0.5f); break;
+    case Primitive::Disc:    b.min = glm::vec3(-1.0f, -1.0f, 0.0f);  b.max = glm::vec3(1.0f, 1.0f, 0.0f); break;
+    case Primitive::Pyramid: b.min = glm::vec3(-1.0f, 0.0f, -1.0f);  b.max = glm::vec3(1.0f, 1.0f, 1.0f); break;
+    case Primitive::Quad:    b.min = glm::vec3(-1.0f, 0.0f, -1.0f);  b.max = glm::vec3(1.0f, 0.0f, 1.0f); break;
+    }
+    return b;
+}
@@ -0,0 +1,199 @@
+#include "profiler.h"
+
+#if ROBOT_PROFILE
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Events kept per thread; older ones are overwritten
+static const std::uint64_t kRingSize = 1 << 15;
+// GPU query sets in flight; a set is read back this many frames after it was issued
+static const int kGpuFrames = 3;
+static const int kMaxGpuScopes = 64;
+
+struct TraceEvent {
+    const char*  name;
+    std::int64_t start;   // ns since profiler start
+    std::int64_t end;
+};
+
+// Single-producer ring: only the owning thread writes, the trace writer
+// reads a snapshot and discards anything overwritten while it copied
+struct ThreadTrace {
+    int                        tid;
+    std::string                name;
+    std::atomic<std::uint64_t> head{0};
+    TraceEvent                 events[kRingSize];
+
+    void push(const TraceEvent& e) {
+        std::uint64_t h = head.load(std::memory_order_relaxed);
+        events[h & (kRingSize - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+static std::mutex                                registryMutex;
+static std::vector<std::unique_ptr<ThreadTrace>> registry;   // guarded by registryMutex
+
+static std::int64_t nowNs() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+}
+
+static ThreadTrace* registerTrace(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.emplace_back(new ThreadTrace());
+    registry.back()->tid  = (int)registry.size();
+    registry.back()->name = name;
+    return registry.back().get();
+}
+
+static ThreadTrace& threadTrace() {
+    thread_local ThreadTrace* trace = registerTrace("thread");
+    return *trace;
+}
+
+ProfileScope::ProfileScope(const char* scopeName) : name(scopeName), start(nowNs()) {}
+
+ProfileScope::~ProfileScope() {
+    threadTrace().push({name, start, nowNs()});
+}
+
+void profileThreadName(const char* name, int index) {
+    std::string label = name;
+    if (index >= 0) label += " " + std::to_string(index);
+    ThreadTrace& trace = threadTrace();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    trace.name = label;
+}
+
+// ------------------------------------------------
+// GPU scopes
+// ------------------------------------------------
+struct GpuFrame {
+    GLuint      queries[2 * kMaxGpuScopes];   // begin/end timestamp per scope
+    const char* names[kMaxGpuScopes];
+    int         count;
+};
+
+static GpuFrame     gpuFrames[kGpuFrames];
+static int          gpuFrame  = 0;
+static bool         gpuReady  = false;
+static std::int64_t gpuOffset = 0;       // CPU ns minus GPU ns
+static ThreadTrace* gpuTrace  = nullptr;
+
+void profileInitGpu() {
+    if (gpuReady) return;
+    for (GpuFrame& f : gpuFrames) {
+        glGenQueries(2 * kMaxGpuScopes, f.queries);
+        f.count = 0;
+    }
+    // Line the GPU clock up with the CPU clock once
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    gpuOffset = nowNs() - gpuNow;
+    if (!gpuTrace) gpuTrace = registerTrace("GPU");
+    gpuReady = true;
+}
+
+void profileShutdownGpu() {
+    if (!gpuReady) return;
+    for (GpuFrame& f : gpuFrames) glDeleteQueries(2 * kMaxGpuScopes, f.queries);
+    gpuReady = false;
+}
+
+GpuProfileScope::GpuProfileScope(const char* name) : slot(-1) {
+    GpuFrame& f = gpuFrames[gpuFrame];
+    if (!gpuReady || f.count == kMaxGpuScopes) return;
+    slot = f.count++;
+    f.names[slot] = name;
+    glQueryCounter(f.queries[2 * slot], GL_TIMESTAMP);
+}
+
+GpuProfileScope::~GpuProfileScope() {
+    if (slot >= 0) glQueryCounter(gpuFrames[gpuFrame].queries[2 * slot + 1], GL_TIMESTAMP);
+}
+
+void profileEndFrame() {
+    if (!gpuReady) return;
+    gpuFrame = (gpuFrame + 1) % kGpuFrames;
+
+    // The set about to be reused was issued kGpuFrames - 1 frames ago.
+    // If it is somehow still in flight, drop it rather than wait.
+    GpuFrame& f = gpuFrames[gpuFrame];
+    if (f.count > 0) {
+        GLint ready = 0;
+        glGetQueryObjectiv(f.queries[2 * f.count - 1], GL_QUERY_RESULT_AVAILABLE, &ready);
+        for (int i = 0; ready && i < f.count; ++i) {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(f.queries[2 * i], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(f.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+            gpuTrace->push({f.names[i], (std::int64_t)begin + gpuOffset, (std::int64_t)end + gpuOffset});
+        }
+    }
+    f.count = 0;
+}
+
+// ------------------------------------------------
+// Trace export
+// ------------------------------------------------
+static void writeEscaped(std::ostream& os, const std::string& s) {
+    for (char c : s) {
+        if (c == '"' || c == '\\') os << '\\';
+        os << c;
+    }
+}
+
+bool profileWriteTrace(const std::string& path) {
+    std::ofstream os(path);
+    if (!os) {
+        std::cerr << "Failed to open trace output: " << path << "\n";
+        return false;
+    }
+
+    os << std::fixed << std::setprecision(3);   // microseconds with ns resolution
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<TraceEvent> copy;
+    bool first = true;
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (const auto& trace : registry) {
+        os << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+           << trace->tid << ", \"args\": {\"name\": \"";
+        writeEscaped(os, trace->name);
+        os << "\"}}";
+        first = false;
+
+        // Snapshot, then keep only entries the producer cannot have overwritten meanwhile
+        std::uint64_t head  = trace->head.load(std::memory_order_acquire);
+        std::uint64_t count = std::min(head, kRingSize);
+        copy.clear();
+        for (std::uint64_t i = head - count; i < head; ++i)
+            copy.push_back(trace->events[i & (kRingSize - 1)]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t after = trace->head.load(std::memory_order_relaxed);
+        std::uint64_t valid = after + 1 > kRingSize ? after + 1 - kRingSize : 0;
+
+        for (std::uint64_t i = 0; i < copy.size(); ++i) {
+            if (head - count + i < valid) continue;
+            const TraceEvent& e = copy[i];
+            os << ",\n{\"name\": \"";
+            writeEscaped(os, e.name);
+            os << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << trace->tid
+               << ", \"ts\": " << e.start / 1000.0 << ", \"dur\": " << (e.end - e.start) / 1000.0 << "}";
+        }
+    }
+    os << "\n]}\n";
+    return true;
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include "render_device.h"
+
+static GlDevice      gGlDevice;
+static RenderDevice* gDevice = &gGlDevice;
+
+RenderDevice& renderDevice() {
+    return *gDevice;
+}
+
+void setRenderDevice(RenderDevice* device) {
+    gDevice = device ? device : &gGlDevice;
+}
+
+// ------------------------------------------------
+// GL
+// ------------------------------------------------
+GLuint GlDevice::createBuffer() {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void GlDevice::deleteBuffer(GLuint buffer) { glDeleteBuffers(1, &buffer); }
+void GlDevice::bindBuffer(GLenum target, GLuint buffer) { glBindBuffer(target, buffer); }
+
+void GlDevice::bufferData(GLenum target, GLsizeiptr bytes, const void* data, GLenum usage) {
+    glBufferData(target, bytes, data, usage);
+}
+
+void GlDevice::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr bytes, const void* data) {
+    glBufferSubData(target, offset, bytes, data);
+}
+
+GLuint GlDevice::createVertexArray() {
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    return vao;
+}
+
+void GlDevice::deleteVertexArray(GLuint vao) { glDeleteVertexArrays(1, &vao); }
+void GlDevice::bindVertexArray(GLuint vao) { glBindVertexArray(vao); }
+
+void GlDevice::vertexAttribute(GLuint index, GLint size, GLsizei stride, std::size_t offset) {
+    glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+    glEnableVertexAttribArray(index);
+}
+
+void GlDevice::useProgram(GLuint program) { glUseProgram(program); }
+void GlDevice::deleteProgram(GLuint program) { glDeleteProgram(program); }
+
+void GlDevice::activeUniforms(GLuint program, std::vector<std::pair<std::string, GLint>>& out) {
+    out.clear();
+    int count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; ++i) {
+        char name[256];
+        GLsizei len = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), &len, &size, &type, name);
+        out.emplace_back(std::string(name, len), glGetUniformLocation(program, name));
+    }
+}
+
+GLint GlDevice::uniformLocation(GLuint program, const char* name) {
+    return glGetUniformLocation(program, name);
+}
+
+void GlDevice::uniformBlockBinding(GLuint program, const char* block, GLuint binding) {
+    GLuint index = glGetUniformBlockIndex(program, block);
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, binding);
+}
+
+// Without binding the program (GL 4.1)
+void GlDevice::programUniform1i(GLuint program, GLint location, GLint value) {
+    glProgramUniform1i(program, location, value);
+}
+
+void GlDevice::uniformMatrix4(GLint location, const float* value) { glUniformMatrix4fv(location, 1, GL_FALSE, value); }
+void GlDevice::uniformMatrix3(GLint location, const float* value) { glUniformMatrix3fv(location, 1, GL_FALSE, value); }
+void GlDevice::uniform3(GLint location, const float* value) { glUniform3fv(location, 1, value); }
+void GlDevice::uniform1f(GLint location, float value) { glUniform1f(location, value); }
+void GlDevice::uniform1i(GLint location, GLint value) { glUniform1i(location, value); }
+
+void GlDevice::drawElements(GLenum mode, GLsizei count, GLuint firstIndex, GLint baseVertex) {
+    glDrawElementsBaseVertex(mode, count, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(GLuint)), baseVertex);
+}
+
+void GlDevice::drawElementsInstanced(GLenum mode, GLsizei count, GLuint firstIndex,
+                                     GLsizei instances, GLint baseVertex) {
+    glDrawElementsInstancedBaseVertex(mode, count, GL_UNSIGNED_INT,
+                                      (void*)(firstIndex * sizeof(GLuint)), instances, baseVertex);
+}
+
+// ------------------------------------------------
+// Recording
+// ------------------------------------------------
+void RecordingDevice::record(DeviceOp op, GLenum target, GLuint object, std::int64_t size) {
+    stream.push_back({op, target, object, size});
+    ++counts.commands;
+}
+
+void RecordingDevice::clear() {
+    stream.clear();
+    counts = DeviceCounters();
+}
+
+GLuint& RecordingDevice::boundBuffer(GLenum target) {
+    for (auto& b : buffers)
+        if (b.first == target) return b.second;
+    buffers.emplace_back(target, 0);
+    return buffers.back().second;
+}
+
+const std::vector<std::string>* RecordingDevice::uniformsOf(GLuint id) const {
+    for (const auto& p : programs)
+        if (p.first == id) return &p.second;
+    return nullptr;
+}
+
+GLuint RecordingDevice::addProgram(const std::vector<std::string>& uniforms) {
+    programs.emplace_back(nextName, uniforms);
+    return nextName++;
+}
+
+GLuint RecordingDevice::createBuffer() {
+    record(DeviceOp::CreateBuffer, 0, nextName, 0);
+    ++counts.bufferCreates;
+    return nextName++;
+}
+
+void RecordingDevice::deleteBuffer(GLuint buffer) {
+    for (auto& b : buffers)
+        if (b.second == buffer) b.second = 0;
+    record(DeviceOp::DeleteBuffer, 0, buffer, 0);
+}
+
+void RecordingDevice::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint& bound = boundBuffer(target);
+    if (bound == buffer) ++counts.redundantBinds;
+    bound = buffer;
+    record(DeviceOp::BindBuffer, target, buffer, 0);
+    ++counts.bufferBinds;
+}
+
+void RecordingDevice::bufferData(GLenum target, GLsizeiptr bytes, const void*, GLenum) {
+    record(DeviceOp::BufferData, target, boundBuffer(target), bytes);
+    ++counts.bufferUploads;
+    counts.uploadBytes += bytes;
+}
+
+void RecordingDevice::bufferSubData(GLenum target, GLintptr, GLsizeiptr bytes, const void*) {
+    record(DeviceOp::BufferSubData, target, boundBuffer(target), bytes);
+    ++counts.bufferUploads;
+    counts.uploadBytes += bytes;
+}
+
+GLuint RecordingDevice::createVertexArray() {
+    record(DeviceOp::CreateVertexArray, 0, nextName, 0);
+    ++counts.vaoCreates;
+    return nextName++;
+}
+
+void RecordingDevice::deleteVertexArray(GLuint array) {
+    if (vao == array) vao = 0;
+    record(DeviceOp::DeleteVertexArray, 0, array, 0);
+}
+
+void RecordingDevice::bindVertexArray(GLuint array) {
+    if (vao == array) ++counts.redundantBinds;
+    vao = array;
+    record(DeviceOp::BindVertexArray, 0, array, 0);
+    ++counts.vaoBinds;
+}
+
+void RecordingDevice::vertexAttribute(GLuint index, GLint size, GLsizei, std::size_t) {
+    record(DeviceOp::VertexAttribute, index, vao, size);
+}
+
+void RecordingDevice::useProgram(GLuint id) {
+    if (program == id) ++counts.redundantBinds;
+    program = id;
+    record(DeviceOp::UseProgram, 0, id, 0);
+    ++counts.programBinds;
+}
+
+void RecordingDevice::deleteProgram(GLuint id) {
+    if (program == id) program = 0;
+    record(DeviceOp::DeleteProgram, 0, id, 0);
+}
+
+void RecordingDevice::activeUniforms(GLuint id, std::vector<std::pair<std::string, GLint>>& out) {
+    out.clear();
+    if (const std::vector<std::string>* names = uniformsOf(id))
+        for (size_t i = 0; i < names->size(); ++i) out.emplace_back((*names)[i], (GLint)i);
+}
+
+GLint RecordingDevice::uniformLocation(GLuint id, const char* name) {
+    const std::vector<std::string>* names = uniformsOf(id);
+    if (!names) return -1;
+    // Like GL, an array answers to its bare name too
+    std::string array = std::string(name) + "[0]";
+    for (size_t i = 0; i < names->size(); ++i)
+        if ((*names)[i] == name || (*names)[i] == array) return (GLint)i;
+    return -1;
+}
+
+// Stand-in programs have no blocks
+void RecordingDevice::uniformBlockBinding(GLuint id, const char*, GLuint binding) {
+    record(DeviceOp::UniformBlockBinding, binding, id, 0);
+}
+
+void RecordingDevice::programUniform1i(GLuint id, GLint location, GLint) {
+    record(DeviceOp::Uniform, 0, (GLuint)location, 1);
+    ++counts.uniformSets;
+}
+
+void RecordingDevice::uniformMatrix4(GLint location, const float*) {
+    record(DeviceOp::Uniform, 0, (GLuint)location, 16);
+    ++counts.uniformSets;
+}
+
+void RecordingDevice::uniformMatrix3(GLint location, const float*) {
+    record(DeviceOp::Uniform, 0, (GLuint)location, 9);
+    ++counts.uniformSets;
+}
+
+void RecordingDevice::uniform3(GLint location, const float*) {
+    record(DeviceOp::Uniform, 0, (GLuint)location, 3);
+    ++counts.uniformSets;
+}
+
+void RecordingDevice::uniform1f(GLint location, float) {
+    record(DeviceOp::Uniform, 0, (GLuint)location, 1);
+    ++counts.uniformSets;
+}
+
+void RecordingDevice::uniform1i(GLint location, GLint) {
+    record(DeviceOp::Uniform, 0, (GLuint)location, 1);
+    ++counts.uniformSets;
+}
+
+void RecordingDevice::drawElements(GLenum mode, GLsizei count, GLuint, GLint) {
+    record(DeviceOp::Draw, 1, mode, count);
+    ++counts.drawCalls;
+    counts.indices += count;
+}
+
+void RecordingDevice::drawElementsInstanced(GLenum mode, GLsizei count, GLuint, GLsizei instances, GLint) {
+    record(DeviceOp::DrawInstanced, (GLenum)instances, mode, count);
+    ++counts.drawCalls;
+    counts.indices += (std::int64_t)count * instances;
+}
@@ -0,0 +1,173 @@
+#include "render_queue.h"
+#include "render_device.h"
+#include "transform.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+// Key layout, most significant first: program 6 | VAO 18 | material 16 | depth 24.
+// Depth sorts front to back inside one state so early-z rejects hidden pixels.
+static const int   kProgramBits  = 6;
+static const int   kVaoBits      = 18;
+static const int   kMaterialBits = 16;
+static const int   kDepthBits    = 24;
+static const float kDepthRange   = 128.0f;   // view distance mapped onto the depth bits
+static_assert(kProgramBits + kVaoBits + kMaterialBits + kDepthBits == 64, "sort key must fill 64 bits");
+
+static std::uint64_t makeKey(int program, GLuint vao, int material, float depth) {
+    float d = glm::clamp(depth / kDepthRange, 0.0f, 1.0f);
+    std::uint64_t q = (std::uint64_t)(d * ((1u << kDepthBits) - 1));
+    return ((std::uint64_t)program << (kVaoBits + kMaterialBits + kDepthBits)) |
+           ((std::uint64_t)(vao & ((1u << kVaoBits) - 1)) << (kMaterialBits + kDepthBits)) |
+           ((std::uint64_t)(material & ((1u << kMaterialBits) - 1)) << kDepthBits) |
+           q;
+}
+
+void RenderQueue::Program::lookUp() {
+    generation   = shader->generation();
+    modelView    = shader->uniform("uModelView");
+    normalMatrix = shader->uniform("uNormalMatrix");
+    baseColor    = shader->uniform("uBaseColor");
+}
+
+int RenderQueue::programIndex(Shader& shader) {
+    for (size_t i = 0; i < programs.size(); ++i)
+        if (programs[i].shader == &shader) return (int)i;
+    assert(programs.size() < (1u << kProgramBits) && "more programs than the sort key holds");
+    Program p;
+    p.shader = &shader;
+    p.lookUp();
+    programs.push_back(p);
+    return (int)programs.size() - 1;
+}
+
+// FNV-1a over the colour's bits
+static std::size_t colorHash(const glm::vec3& color) {
+    std::uint32_t bits[3];
+    std::memcpy(bits, &color[0], sizeof(bits));
+    std::uint32_t h = 2166136261u;
+    for (std::uint32_t b : bits) h = (h ^ b) * 16777619u;
+    return h;
+}
+
+// Open addressing with linear probing, kept at most half full
+int RenderQueue::materialIndex(const glm::vec3& color) {
+    if ((materials.size() + 1) * 2 > materialSlots.size()) growMaterialSlots();
+    std::size_t mask = materialSlots.size() - 1;
+    for (std::size_t i = colorHash(color) & mask;; i = (i + 1) & mask) {
+        int slot = materialSlots[i];
+        if (slot == 0) {
+            assert(materials.size() < (1u << kMaterialBits) && "more colours in a frame than the sort key holds");
+            materials.push_back(color);
+            materialSlots[i] = (int)materials.size();
+            return (int)materials.size() - 1;
+        }
+        if (materials[slot - 1] == color) return slot - 1;
+    }
+}
+
+void RenderQueue::growMaterialSlots() {
+    materialSlots.assign(std::max<std::size_t>(64, materialSlots.size() * 2), 0);
+    std::size_t mask = materialSlots.size() - 1;
+    for (std::size_t m = 0; m < materials.size(); ++m) {
+        std::size_t i = colorHash(materials[m]) & mask;
+        while (materialSlots[i] != 0) i = (i + 1) & mask;
+        materialSlots[i] = (int)m + 1;
+    }
+}
+
+void RenderQueue::begin(FrameArena& frameArena, const glm::mat4& viewMatrix) {
+    arena = &frameArena;
+    view  = viewMatrix;
+    entries.clear();
+    // Material ids only have to hold until this frame's flush
+    materials.clear();
+    std::fill(materialSlots.begin(), materialSlots.end(), 0);
+    counters = RenderStats();
+    lastProgram = lastMaterial = -1;
+    lastVao = 0;
+}
+
+void RenderQueue::submit(Shader& shader, const Mesh& mesh, const glm::vec3& color, const glm::mat4& model) {
+    Packet* p   = arena->allocateArray<Packet>(1);
+    p->mesh     = &mesh;
+    p->model    = model;
+    p->program  = programIndex(shader);
+    p->material = materialIndex(color);
+
+    float depth = -(view * model[3]).z;
+    entries.push_back({makeKey(p->program, mesh.vao, p->material, depth), p});
+
+    // What drawing in submission order would have changed
+    if (p->program != lastProgram) { ++counters.unsortedProgramChanges; lastMaterial = -1; }
+    if (mesh.vao != lastVao)        ++counters.unsortedVaoChanges;
+    if (p->material != lastMaterial) ++counters.unsortedMaterialChanges;
+    lastProgram  = p->program;
+    lastVao      = mesh.vao;
+    lastMaterial = p->material;
+}
+
+void RenderQueue::useIndirect(IndirectRenderer* renderer, Shader* program) {
+    multiDraw       = renderer;
+    multiDrawShader = program;
+}
+
+void RenderQueue::flush() {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+    if (indirect() && multiDrawShader) {
+        // Per-draw state goes into the draw-data buffer; one program and VAO for all
+        for (const Entry& e : entries) {
+            const Packet& p = *e.packet;
+            DrawTransform t = makeDrawTransform(view, p.model);
+            multiDraw->add(*p.mesh, t.modelView, t.normal, materials[p.material]);
+        }
+        multiDraw->submit(*multiDrawShader);
+        counters.programChanges = counters.vaoChanges = entries.empty() ? 0 : 1;
+        counters.materialChanges = 0;
+        counters.drawCalls = multiDraw->drawCalls();
+        counters.packets   = (int)entries.size();
+        entries.clear();
+        return;
+    }
+
+    RenderDevice& device = renderDevice();
+    int    program  = -1;
+    int    material = -1;
+    GLuint vao      = 0;
+    for (const Entry& e : entries) {
+        const Packet& p = *e.packet;
+        Program& prog = programs[p.program];
+
+        if (p.program != program) {
+            // The shader adopted its real program since the handles were taken
+            if (prog.generation != prog.shader->generation()) prog.lookUp();
+            prog.shader->use();
+            program  = p.program;
+            material = -1;   // colour is per-program state
+            ++counters.programChanges;
+        }
+        if (p.mesh->vao != vao) {
+            vao = p.mesh->vao;
+            device.bindVertexArray(vao);
+            ++counters.vaoChanges;
+        }
+        if (p.material != material) {
+            material = p.material;
+            prog.shader->setVec3(prog.baseColor, materials[material]);
+            ++counters.materialChanges;
+        }
+
+        DrawTransform t = makeDrawTransform(view, p.model);
+        prog.shader->setMat4(prog.modelView, t.modelView);
+        prog.shader->setMat3(prog.normalMatrix, t.normal);
+
+        device.drawElements(p.mesh->mode, p.mesh->count, p.mesh->firstIndex, p.mesh->baseVertex);
+        ++counters.drawCalls;
+    }
+    device.bindVertexArray(0);
+
+    counters.packets = (int)entries.size();
+    entries.clear();
+}
@@ -0,0 +1,225 @@
+#include "robot_crowd.h"
+#include <glm/gtc/matrix_inverse.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Cheap deterministic hash -> [0, 1)
+static float hash01(std::uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352dU;
+    x ^= x >> 15; x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return (x & 0xFFFFFF) / float(0x1000000);
+}
+
+RobotCrowd::RobotCrowd() : lastDrawCalls(0), curvedDiameter(0.0f) {
+    for (int& start : levelStart) start = 0;
+    for (long long& t : levelTriangles) t = 0;
+}
+
+void RobotCrowd::init(int count) {
+    robots.assign(count, Robot());
+    phases.resize(count);
+
+    const float spacing = 1.5f;
+    int side = (int)std::ceil(std::sqrt((float)count));
+    float offset = (side - 1) * spacing * 0.5f;
+
+    for (int i = 0; i < count; ++i) {
+        Robot& r = robots[i];
+        r.setPosition(glm::vec3((i % side) * spacing - offset, 0.0f, (i / side) * spacing - offset));
+        r.setBaseRotation(360.0f * hash01(i * 3 + 0));
+        r.raiseRightArm(90.0f * hash01(i * 3 + 1));
+        phases[i] = 6.2831853f * hash01(i * 3 + 2);
+    }
+
+    const Skeleton& skeleton = robotSkeleton();
+    pose.resize(skeleton, count);
+    partWorld.resize(pose.paddedSize() * skeleton.partCount());
+
+    // One batch per distinct (mesh, tessellation) over all LOD levels; each
+    // part gets a fixed slot in the batch it uses at each level
+    const int parts = skeleton.partCount();
+    batches.clear();
+    partBatch.assign(kLodLevels * parts, 0);
+    partSlot.assign(kLodLevels * parts, 0);
+    for (int level = 0; level < kLodLevels; ++level) {
+        std::vector<int> slots;
+        for (int k = 0; k < parts; ++k) {
+            int tess = lodTessellation(skeleton.partTessellation[k], level);
+            size_t b = 0;
+            while (b < batches.size() && !(batches[b].mesh == skeleton.partMesh[k] &&
+                                           batches[b].tessellation == tess))
+                ++b;
+            if (b == batches.size())
+                batches.push_back({skeleton.partMesh[k], tess, 0, level, level, 0, {}});
+            slots.resize(batches.size(), 0);
+
+            Batch& batch = batches[b];
+            batch.lastLevel = level;
+            partBatch[level * parts + k] = (int)b;
+            partSlot[level * parts + k]  = slots[b]++;
+            if (batch.firstLevel == level) batch.partsPerRobot = slots[b];
+        }
+    }
+    for (Batch& b : batches) b.instances.resize((size_t)count * b.partsPerRobot);
+
+    curvedDiameter = 0.0f;
+    for (int k = 0; k < parts; ++k)
+        if (skeleton.partTessellation[k] > 0)
+            curvedDiameter = std::max(curvedDiameter, partDiameter(skeleton, k));
+    robotLod.assign(count, -1);
+    ordered.clear();
+    ordered.reserve(count);
+    for (int& start : levelStart) start = 0;
+
+    robotBounds.assign(count, AABB());
+    bvh = Bvh();
+    visible.clear();
+    visible.reserve(count);
+}
+
+// Give every batch a VAO reading its mesh plus per-instance attributes
+void RobotCrowd::initGPU() {
+    // Room for every part of every robot at full detail before it has to grow
+    const Skeleton& skeleton = robotSkeleton();
+    if (!instanceStream.buffer())
+        instanceStream.init(GL_ARRAY_BUFFER, (GLsizeiptr)size() * skeleton.partCount() * sizeof(InstanceData) +
+                                             (GLsizeiptr)batches.size() * 16);   // alignment of each batch
+
+    for (Batch& b : batches) {
+        if (b.vao) continue;
+        meshRegistry().get(b.mesh, b.tessellation);
+        b.vao = meshRegistry().makeVertexArray();
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceStream.buffer());
+        setInstanceLayout(0);
+        enableInstanceAttributes();
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Triangles one robot costs at each level
+    for (int level = 0; level < kLodLevels; ++level) {
+        levelTriangles[level] = 0;
+        for (int k = 0; k < skeleton.partCount(); ++k) {
+            const Batch& b = batches[partBatch[level * skeleton.partCount() + k]];
+            levelTriangles[level] += MeshRegistry::triangleCount(meshRegistry().get(b.mesh, b.tessellation));
+        }
+    }
+}
+
+void RobotCrowd::destroyGPU() {
+    for (Batch& b : batches) {
+        if (b.vao) glDeleteVertexArrays(1, &b.vao);
+        b.vao = 0;
+    }
+    instanceStream.destroy();
+}
+
+void RobotCrowd::updateRange(float tSeconds, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        robots[i].animateHead(tSeconds + phases[i]);
+        robots[i].animateLegs(tSeconds + phases[i]);
+        robots[i].writePose(pose, i);
+    }
+    solveForwardKinematics(robotSkeleton(), pose, begin, end, partWorld.data());
+
+    // Each robot is bounded by the union of its parts
+    const Skeleton& skeleton = robotSkeleton();
+    const int parts = skeleton.partCount();
+    for (int r = begin; r < end; ++r) {
+        const glm::mat4* world = &partWorld[(size_t)r * parts];
+        AABB box;
+        for (int k = 0; k < parts; ++k)
+            box.expand(transformBounds(world[k], MeshRegistry::localBounds(skeleton.partMesh[k])));
+        robotBounds[r] = box;
+    }
+}
+
+void RobotCrowd::writeInstances(int begin, int end) {
+    // Scatter solved part matrices into the per-mesh instance arrays
+    const Skeleton& skeleton = robotSkeleton();
+    const int parts = skeleton.partCount();
+    for (int v = begin; v < end; ++v) {
+        int r     = ordered[v];
+        int level = robotLod[r];
+        const glm::mat4* world = &partWorld[(size_t)r * parts];
+        for (int k = 0; k < parts; ++k) {
+            Batch& b = batches[partBatch[level * parts + k]];
+            size_t index = (size_t)(v - levelStart[b.firstLevel]) * b.partsPerRobot + partSlot[level * parts + k];
+            InstanceData& inst = b.instances[index];
+            inst.model  = world[k];
+            inst.normal = glm::inverseTranspose(glm::mat3(world[k]));
+            inst.color  = skeleton.partColor[k];
+        }
+    }
+}
+
+void RobotCrowd::update(float tSeconds, JobSystem& jobs) {
+    // Ranges are multiples of 4 robots to match the SIMD solver
+    const int grain = 256;
+    jobs.parallelFor(0, size(), grain, [this, tSeconds](int begin, int end) {
+        updateRange(tSeconds, begin, end);
+    });
+}
+
+void RobotCrowd::cull(const Frustum& frustum, JobSystem& jobs, const LodView& lod) {
+    // Robots stay on their grid cell, so the first tree keeps its quality
+    if (bvh.size() != size())
+        bvh.build(robotBounds);
+    else
+        bvh.refit(robotBounds.data());
+
+    stats = CullStats();
+    visible.clear();
+    bvh.cull(frustum, visible, stats);
+
+    // Pick levels, then group robots by level (counting sort) so every
+    // batch reads one contiguous run of robots
+    int counts[kLodLevels] = {};
+    for (int r : visible) {
+        float pixels = projectedPixels(lod, robotBounds[r].center(), curvedDiameter);
+        robotLod[r] = selectLod(pixels, robotLod[r]);
+        ++counts[robotLod[r]];
+    }
+    levelStart[0] = 0;
+    for (int level = 0; level < kLodLevels; ++level)
+        levelStart[level + 1] = levelStart[level] + counts[level];
+    int next[kLodLevels];
+    std::copy(levelStart, levelStart + kLodLevels, next);
+    ordered.resize(visible.size());
+    for (int r : visible) ordered[next[robotLod[r]]++] = r;
+
+    jobs.parallelFor(0, (int)ordered.size(), 256, [this](int begin, int end) {
+        writeInstances(begin, end);
+    });
+}
+
+// One instanced call per mesh type; the main thread only issues GL commands
+void RobotCrowd::draw() {
+    lastDrawCalls = 0;
+    lodCounts = LodStats();
+    for (int level = 0; level < kLodLevels; ++level) {
+        lodCounts.instances[level] = levelStart[level + 1] - levelStart[level];
+        lodCounts.triangles[level] = lodCounts.instances[level] * levelTriangles[level];
+    }
+    for (Batch& b : batches) {
+        size_t count = (size_t)(levelStart[b.lastLevel + 1] - levelStart[b.firstLevel]) * b.partsPerRobot;
+        if (count == 0) continue;
+        // Instances land at a different offset (and after growth, buffer) each frame
+        GLintptr offset = instanceStream.write(b.instances.data(), count * sizeof(InstanceData));
+        glBindVertexArray(b.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceStream.buffer());
+        setInstanceLayout(offset);
+        MeshRegistry::drawInstanced(meshRegistry().get(b.mesh, b.tessellation), b.vao,
+                                    (GLsizei)count);
+        ++lastDrawCalls;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceStream.endFrame();
+}
+
+int RobotCrowd::size() const { return (int)robots.size(); }
+int RobotCrowd::drawCalls() const { return lastDrawCalls; }
@@ -1,86 +1,29 @@
 #include "scene.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <vector>
 #include <cmath>
+#include <vector>
 
 Scene::Scene()
-    : currentScene(1),
-      groundVAO(0), groundVBO(0),
-      starVAO(0), starVBO(0), starCount(0) {}
+    : currentScene(1), built(false), starsVisible(false), lightOverride(-1) {}
 
 // Set the current scene index (1, 2, or 3)
 void Scene::setScene(int s) {
     if (s < 1) s = 1;
     if (s > 3) s = 3;
+    if (s == currentScene && built) return;
     currentScene = s;
+    buildItems();
 }
 
-// Initialize ground geometry
+// Ground quad from the shared geometry buffers
 void Scene::ensureGround() {
-    if (groundVAO) return;
-
-    // positions + normals
-    struct PN { float x,y,z, nx,ny,nz; };
-    PN verts[] = {
-        {-5,0,-5, 0,1,0}, { 5,0,-5, 0,1,0}, { 5,0, 5, 0,1,0},
-        {-5,0,-5, 0,1,0}, { 5,0, 5, 0,1,0}, {-5,0, 5, 0,1,0}
-    };
-
-    glGenVertexArrays(1, &groundVAO);
-    glGenBuffers(1, &groundVBO);
-
-    glBindVertexArray(groundVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PN), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(PN), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
+    if (groundMesh.count) return;
+    groundMesh = meshRegistry().get(Primitive::Quad);
 }
 
-// Initialize star geometry (for space scene)
-void Scene::ensureStars() {
-    if (starVAO) return;
-
-    std::vector<float> data; // x,y,z,nx,ny,nz
-    const int N = 80;
-    data.reserve(N * 6);
-
-    for (int i = 0; i < N; ++i) {
-        float angle  = (float)i * 0.4f;
-        float radius = 12.0f + (i % 5);
-        float height = 4.0f + (i % 7) * 0.4f;
-
-        float x = std::cos(angle) * radius;
-        float z = std::sin(angle) * radius;
-        float y = height;
-
-        data.push_back(x);
-        data.push_back(y);
-        data.push_back(z);
-        data.push_back(0.0f);
-        data.push_back(0.0f);
-        data.push_back(-1.0f);
-    }
-
-    starCount = N;
-
-    glGenVertexArrays(1, &starVAO);
-    glGenBuffers(1, &starVBO);
-
-    glBindVertexArray(starVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, starVBO);
-    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
+void Scene::destroyGPU() {
+    stars.destroyGPU();
+    jungle.destroyGPU();
 }
 
 // Get background color based on scene
@@ -94,86 +37,104 @@ glm::vec3 Scene::clearColor() const {
     }
 }
 
-// Draw the current scene
-void Scene::draw(Shader& shader) {
-    ensureGround();
+int Scene::lightCount() const {
+    if (lightOverride >= 0) return lightOverride;
+    // Beacon only; a few platform lights in space; fireflies in the jungle
+    return currentScene == 1 ? 1 : currentScene == 2 ? 17 : 97;
+}
 
-    if (currentScene == 1)
-        drawGroundScene(shader);
-    else if (currentScene == 2)
-        drawSpaceScene(shader);
-    else
-        drawJungleScene(shader);
+// lowbias32: a well-mixed 32-bit value per light index
+static std::uint32_t lightHash(std::uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
 }
 
-// Scene 1: Default ground
-void Scene::drawGroundScene(Shader& shader) {
-    shader.setVec3("uBaseColor", glm::vec3(0.20f, 0.60f, 0.80f));
-    glm::mat4 model(1.0f);
-    shader.setMat4("uModel", model);
+void Scene::gatherLights(float t, std::vector<PointLight>& out) const {
+    out.clear();
+    int count = lightCount();
+    if (count <= 0) return;
 
-    glBindVertexArray(groundVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
-}
+    // The blue beacon above the robot
+    out.push_back({glm::vec3(0.0f, 1.2f, 0.0f), 8.0f, glm::vec3(0.2f, 0.6f, 1.0f)});
 
-// Scene 2: Space platform + stars
-void Scene::drawSpaceScene(Shader& shader) {
-    ensureStars();
-
-    // Platform
-    shader.setVec3("uBaseColor", glm::vec3(0.20f, 0.20f, 0.28f));
-    glm::mat4 platform(1.0f);
-    platform = glm::translate(platform, glm::vec3(0.0f, -0.3f, 0.0f));
-    platform = glm::scale(platform, glm::vec3(1.8f, 0.05f, 1.8f));
-    shader.setMat4("uModel", platform);
-
-    glBindVertexArray(groundVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
-
-    // Stars
-    shader.setVec3("uBaseColor", glm::vec3(1.0f, 1.0f, 1.0f));
-    glm::mat4 starModel(1.0f);
-    shader.setMat4("uModel", starModel);
-
-    glBindVertexArray(starVAO);
-    glPointSize(3.0f);
-    glDrawArrays(GL_POINTS, 0, starCount);
-    glBindVertexArray(0);
+    // Fireflies: fixed spots on a 12-unit disc, each bobbing and drifting on its own phase
+    static const glm::vec3 palette[3] = {
+        glm::vec3(1.0f, 0.8f, 0.3f), glm::vec3(0.6f, 1.0f, 0.3f), glm::vec3(1.0f, 0.4f, 0.2f)
+    };
+    for (int i = 1; i < count; ++i) {
+        std::uint32_t h = lightHash((std::uint32_t)i * 0x9e3779b9u);
+        float angle  = (h & 0xffff) * (6.2831853f / 65536.0f);
+        float dist   = 2.0f + 10.0f * std::sqrt(((h >> 16) & 0xff) / 255.0f);
+        float phase  = (h >> 24) * (6.2831853f / 256.0f);
+        float height = 0.4f + 1.6f * (lightHash(h) & 0xff) / 255.0f;
+        float drift  = angle + 0.05f * std::sin(0.3f * t + phase);
+
+        glm::vec3 pos(dist * std::cos(drift), height + 0.3f * std::sin(1.7f * t + phase), dist * std::sin(drift));
+        float radius = 1.5f + 1.5f * ((lightHash(h + 1) & 0xff) / 255.0f);
+        out.push_back({pos, radius, palette[h % 3] * 0.8f});
+    }
 }
 
-// Scene 3: Jungle ground + small bushes
-void Scene::drawJungleScene(Shader& shader) {
-    glBindVertexArray(groundVAO);
+// Describe the active scene as a list of drawables with world bounds
+void Scene::buildItems() {
+    items.clear();
+    if (currentScene == 1) {
+        // Default ground
+        items.push_back({GROUND, glm::mat4(1.0f), glm::vec3(0.20f, 0.60f, 0.80f)});
+    } else if (currentScene == 2) {
+        // Space platform + stars
+        glm::mat4 platform(1.0f);
+        platform = glm::translate(platform, glm::vec3(0.0f, -0.3f, 0.0f));
+        platform = glm::scale(platform, glm::vec3(1.8f, 0.05f, 1.8f));
+        items.push_back({GROUND, platform, glm::vec3(0.20f, 0.20f, 0.28f)});
+        items.push_back({STARS, glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, 1.0f)});
+    }
+    // Jungle: ground and plants come from the vegetation chunks
 
-    // Ground
-    shader.setVec3("uBaseColor", glm::vec3(0.20f, 0.75f, 0.20f));
-    glm::mat4 ground = glm::mat4(1.0f);
-    shader.setMat4("uModel", ground);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Ground-type items are laid out for a 10x10 quad; the shared quad is 2x2
+    for (Item& item : items)
+        if (item.geometry == GROUND) item.model = glm::scale(item.model, glm::vec3(5.0f, 1.0f, 5.0f));
 
-    // Bushes
+    AABB ground = MeshRegistry::localBounds(Primitive::Quad);
+    AABB shell  = stars.bounds();
 
-    shader.setVec3("uBaseColor", glm::vec3(0.10f, 0.50f, 0.15f));
+    std::vector<AABB> bounds;
+    for (const Item& item : items)
+        bounds.push_back(transformBounds(item.model, item.geometry == GROUND ? ground : shell));
+    bvh.build(bounds);
+    built = true;
+}
 
-    // Bush 1
-    {
-        glm::mat4 b1 = glm::mat4(1.0f);
-        b1 = glm::translate(b1, glm::vec3(1.5f, 0.02f, 1.0f));
-        b1 = glm::scale(b1, glm::vec3(0.3f, 1.0f, 0.2f));
-        shader.setMat4("uModel", b1);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+// Queue the visible part of the current scene
+void Scene::draw(RenderQueue& queue, Shader& shader, const Frustum& frustum) {
+    ensureGround();
+    if (!built) buildItems();
+
+    stats = CullStats();
+    visible.clear();
+    bvh.cull(frustum, visible, stats);
+
+    starsVisible = false;
+    for (int i : visible) {
+        const Item& item = items[i];
+        if (item.geometry == STARS) {
+            starsVisible = true;   // drawn by drawStars with its own program
+            continue;
+        }
+        queue.submit(shader, groundMesh, item.color, item.model);
     }
+}
 
-    // Bush 2
-    {
-        glm::mat4 b2 = glm::mat4(1.0f);
-        b2 = glm::translate(b2, glm::vec3(-1.2f, 0.02f, -1.0f));
-        b2 = glm::scale(b2, glm::vec3(0.25f, 1.0f, 0.25f));
-        shader.setMat4("uModel", b2);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-    }
+void Scene::drawStars(Shader& starShader, float tSeconds) {
+    if (starsVisible) stars.draw(starShader, tSeconds);
+}
 
-    glBindVertexArray(0);
-}
\ No newline at end of file
+void Scene::drawVegetation(Shader& instancedShader, const glm::vec3& eye, const Frustum& frustum,
+                           std::pmr::memory_resource* scratch) {
+    if (currentScene != 3) return;
+    jungle.update(eye, scratch);
+    instancedShader.use();
+    jungle.draw(frustum);
+}
@@ -0,0 +1,146 @@
+#include "shader_cache.h"
+#include "Shader.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Bump when the file layout changes
+static const std::uint32_t kCacheMagic = 0x52424331;   // "RBC1"
+
+// 64-bit FNV-1a, chained over several strings
+static std::uint64_t hashString(const std::string& s, std::uint64_t h = 1469598103934665603ull) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h ^ 0xff;   // separator so ("ab","c") != ("a","bc")
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? (const char*)s : "";
+}
+
+ShaderCache::ShaderCache(std::string directory)
+    : dir(std::move(directory)), enabled(true) {}
+
+std::string ShaderCache::injectDefines(const std::string& code, const std::string& defines) {
+    if (defines.empty()) return code;
+    size_t version = code.find("#version");
+    size_t eol = version == std::string::npos ? std::string::npos : code.find('\n', version);
+    if (eol == std::string::npos) return defines + "\n" + code;
+    return code.substr(0, eol + 1) + defines + "\n" + code.substr(eol + 1);
+}
+
+std::string ShaderCache::path(std::uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return dir + "/" + name;
+}
+
+GLuint ShaderCache::build(const ProgramSource& source) {
+    std::string vCode = ShaderCache::injectDefines(Shader::readFile(source.vertexPath.c_str()), source.defines);
+    std::string fCode = ShaderCache::injectDefines(Shader::readFile(source.fragmentPath.c_str()), source.defines);
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    bool cacheable = enabled && formats > 0;
+
+    std::uint64_t key = 0;
+    if (cacheable) {
+        key = hashString(vCode);
+        key = hashString(fCode, key);
+        key = hashString(glString(GL_VENDOR), key);
+        key = hashString(glString(GL_RENDERER), key);
+        key = hashString(glString(GL_VERSION), key);
+        if (GLuint program = load(key)) return program;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GLuint program = Shader::link(vCode, fCode);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        ++counters.misses;
+        counters.compileMs += ms;
+    }
+    if (program && cacheable) store(program, key);
+    return program;
+}
+
+// File: magic, binary format, length, then the driver's blob
+GLuint ShaderCache::load(std::uint64_t key) {
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file) return 0;
+
+    std::uint32_t magic = 0, format = 0, length = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+    std::vector<char> blob(file && magic == kCacheMagic ? length : 0);
+    if (!blob.empty()) file.read(blob.data(), length);
+
+    GLuint program = 0;
+    GLint  linked  = 0;
+    if (file && !blob.empty()) {
+        program = glCreateProgram();
+        glProgramBinary(program, (GLenum)format, blob.data(), (GLsizei)length);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+    file.close();
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    if (!linked) {
+        // Corrupt, truncated or from a driver that no longer accepts it
+        if (program) glDeleteProgram(program);
+        std::error_code ec;
+        std::filesystem::remove(path(key), ec);
+        ++counters.rejected;
+        return 0;
+    }
+    ++counters.hits;
+    counters.loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return program;
+}
+
+void ShaderCache::store(GLuint program, std::uint64_t key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> blob(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, blob.data());
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    // Written under a temporary name so a crash never leaves half a binary
+    std::string target = path(key);
+    std::string temp   = target + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file) {
+            std::cerr << "ShaderCache: cannot write " << temp << "\n";
+            return;
+        }
+        std::uint32_t header[3] = {kCacheMagic, (std::uint32_t)format, (std::uint32_t)length};
+        file.write((const char*)header, sizeof(header));
+        file.write(blob.data(), length);
+    }
+    std::filesystem::rename(temp, target, ec);
+}
+
+void ShaderCache::clear() {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec))
+        if (entry.path().extension() == ".bin") std::filesystem::remove(entry.path(), ec);
+}
+
+ShaderCacheStats ShaderCache::stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return counters;
+}
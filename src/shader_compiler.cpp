@@ -0,0 +1,99 @@
+#include "shader_compiler.h"
+#include "profiler.h"
+#include <GLFW/glfw3.h>
+
+ShaderCompiler::ShaderCompiler()
+    : context(nullptr), cache(nullptr), outstanding(0), busy(false), quit(false) {}
+
+ShaderCompiler::~ShaderCompiler() {
+    stop();
+}
+
+void ShaderCompiler::start(GLFWwindow* sharedContext, ShaderCache& shaderCache) {
+    stop();
+    cache   = &shaderCache;
+    context = sharedContext;
+    if (context) worker = std::thread(&ShaderCompiler::workerLoop, this);
+}
+
+void ShaderCompiler::stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    worker.join();
+    quit = false;
+
+    // Built but never adopted: nobody will draw with them
+    for (Job& job : finished)
+        if (job.program) glDeleteProgram(job.program);
+    finished.clear();
+    queue.clear();
+    outstanding = 0;
+}
+
+void ShaderCompiler::request(Shader& target, const ProgramSource& source) {
+    ++outstanding;
+    if (!worker.joinable()) {
+        // No second context: build now on the caller's
+        GLuint program = cache->build(source);
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back({&target, source, program});
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({&target, source, 0});
+    }
+    wake.notify_one();
+}
+
+void ShaderCompiler::workerLoop() {
+    PROFILE_THREAD_NAME("shader compiler");
+    glfwMakeContextCurrent(context);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return quit || !queue.empty(); });
+        if (quit) break;
+
+        Job job = queue.front();
+        queue.pop_front();
+        busy = true;
+        lock.unlock();
+
+        {
+            PROFILE_SCOPE("ShaderCompiler::build");
+            job.program = cache->build(job.source);
+            // The program must be complete before the main context uses it
+            glFinish();
+        }
+
+        lock.lock();
+        finished.push_back(job);
+        busy = false;
+        idle.notify_all();
+    }
+    lock.unlock();
+    glfwMakeContextCurrent(nullptr);
+}
+
+int ShaderCompiler::poll() {
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(finished);
+    }
+    // A failed build keeps the fallback (the error was already printed)
+    for (Job& job : ready)
+        if (job.program) job.target->adopt(job.program);
+    outstanding -= (int)ready.size();
+    return (int)ready.size();
+}
+
+void ShaderCompiler::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && !busy; });
+}
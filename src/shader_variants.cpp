@@ -0,0 +1,59 @@
+#include "shader_variants.h"
+#include <algorithm>
+
+std::uint32_t shaderKey(std::uint32_t features, int pointLights) {
+    return features | ((std::uint32_t)std::min(std::max(pointLights, 0), 15) << 8);
+}
+
+std::string shaderDefines(std::uint32_t key) {
+    std::string defines;
+    if (key & SHADER_LIGHTING)  defines += "#define LIGHTING 1\n";
+    if (key & SHADER_INSTANCED) defines += "#define INSTANCED 1\n";
+    if (key & SHADER_UNLIT)     defines += "#define UNLIT 1\n";
+    if (key & SHADER_CLUSTERED) defines += "#define CLUSTERED 1\n";
+    if (key & SHADER_VERTEX_INVERSE) defines += "#define VERTEX_INVERSE 1\n";
+    defines += "#define NUM_POINT_LIGHTS " + std::to_string((key >> 8) & 0xf) + "\n";
+    return defines;
+}
+
+ShaderVariants::ShaderVariants(std::string vertex, std::string fragment,
+                               ShaderCache& shaderCache, ShaderCompiler* shaderCompiler)
+    : vertexPath(std::move(vertex)), fragmentPath(std::move(fragment)),
+      cache(shaderCache), compiler(shaderCompiler) {}
+
+void ShaderVariants::bindUniformBlock(const char* block, GLuint binding) {
+    blocks.emplace_back(block, binding);
+    for (auto& v : variants) v.second->bindUniformBlock(block, binding);
+}
+
+void ShaderVariants::bindSampler(const char* sampler, GLint unit) {
+    samplers.emplace_back(sampler, unit);
+    for (auto& v : variants) v.second->bindSampler(sampler, unit);
+}
+
+ProgramSource ShaderVariants::source(std::uint32_t key) const {
+    return {vertexPath, fragmentPath, shaderDefines(key)};
+}
+
+Shader& ShaderVariants::get(std::uint32_t key) {
+    auto it = variants.find(key);
+    if (it != variants.end()) return *it->second;
+
+    // Unlit permutations are cheap enough to build now; anything else starts
+    // as its unlit sibling (same vertex inputs and uniforms) when a
+    // background compiler is available
+    std::uint32_t fallbackKey = (key & (SHADER_INSTANCED | SHADER_VERTEX_INVERSE)) | SHADER_UNLIT;
+    bool deferred = compiler && key != fallbackKey;
+    std::unique_ptr<Shader> shader(new Shader(cache.build(source(deferred ? fallbackKey : key))));
+    for (const auto& b : blocks) shader->bindUniformBlock(b.first.c_str(), b.second);
+    for (const auto& s : samplers) shader->bindSampler(s.first.c_str(), s.second);
+    if (deferred) compiler->request(*shader, source(key));
+
+    return *variants.emplace(key, std::move(shader)).first->second;
+}
+
+void ShaderVariants::destroy() {
+    for (auto& v : variants)
+        if (v.second->ID) glDeleteProgram(v.second->ID);
+    variants.clear();
+}
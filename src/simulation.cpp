@@ -0,0 +1,125 @@
+#include "simulation.h"
+#include "profiler.h"
+#include "input_log.h"
+#include <algorithm>
+
+// Per-second rates (matching the old per-frame steps at ~60 fps)
+static const float kCameraSpeed = 2.5f;   // processKeyboard delta per second
+static const float kArmSpeed    = 90.0f;  // degrees per second
+
+void stepSimulation(SimState& s, const InputState& in, float dt) {
+    // Mode switches first so this step already uses them
+    if (in.scene >= 1 && in.scene <= 3) s.scene = in.scene;
+    if (in.cameraMode == 1 || in.cameraMode == 2) s.cameraMode = in.cameraMode;
+
+    // Free camera movement (mode 1)
+    if (s.cameraMode == 1) {
+        const float speed = kCameraSpeed * dt;
+        if (in.forward)  s.camera.processKeyboard(FORWARD,  speed);
+        if (in.backward) s.camera.processKeyboard(BACKWARD, speed);
+        if (in.left)     s.camera.processKeyboard(LEFT,     speed);
+        if (in.right)    s.camera.processKeyboard(RIGHT,    speed);
+        if (in.mouseDX != 0.0f || in.mouseDY != 0.0f)
+            s.camera.processMouse(in.mouseDX, in.mouseDY);
+    }
+
+    ++s.tick;
+    s.time = s.tick * (double)dt;
+
+    // Robot arm control and animation
+    Robot robot;
+    robot.setState(s.robot);
+    if (in.armUp)   robot.raiseRightArm(+kArmSpeed * dt);
+    if (in.armDown) robot.raiseRightArm(-kArmSpeed * dt);
+    robot.animateHead((float)s.time);
+    robot.animateLegs((float)s.time);
+    s.robot = robot.getState();
+}
+
+SimState interpolate(const SimState& a, const SimState& b, float alpha) {
+    SimState s = b;
+    s.time   = a.time + (b.time - a.time) * alpha;
+    s.camera = Camera::lerp(a.camera, b.camera, alpha);
+    s.robot  = lerp(a.robot, b.robot, alpha);
+    return s;
+}
+
+Simulation::Simulation(double hz) : dt(1.0 / hz), running(false), recorder(nullptr) {}
+
+Simulation::~Simulation() { stop(); }
+
+void Simulation::start(const SimState& initial) {
+    if (running) return;
+    latest = {initial, initial};
+    snapshots.writeBuffer() = latest;
+    snapshots.publish();
+
+    startTime = Clock::now();
+    running = true;
+    thread = std::thread(&Simulation::run, this, initial);
+}
+
+void Simulation::stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+}
+
+void Simulation::submitInput(const InputState& input) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    float dx = pendingInput.mouseDX, dy = pendingInput.mouseDY;
+    int scene = input.scene ? input.scene : pendingInput.scene;
+    int mode  = input.cameraMode ? input.cameraMode : pendingInput.cameraMode;
+    pendingInput = input;
+    pendingInput.mouseDX += dx;
+    pendingInput.mouseDY += dy;
+    pendingInput.scene      = scene;
+    pendingInput.cameraMode = mode;
+}
+
+// Simulation thread: catch up on due steps, publish, sleep until the next one
+void Simulation::run(SimState state) {
+    PROFILE_THREAD_NAME("simulation");
+    SimState previous = state;
+    while (running) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+        std::uint64_t due = (std::uint64_t)(elapsed / dt);
+
+        bool stepped = false;
+        while (state.tick < due) {
+            InputState input;
+            {
+                std::lock_guard<std::mutex> lock(inputMutex);
+                input = pendingInput;
+                // One-shot requests and mouse motion are consumed by this step
+                pendingInput.mouseDX = pendingInput.mouseDY = 0.0f;
+                pendingInput.scene = pendingInput.cameraMode = 0;
+            }
+            if (recorder) recorder->record(state.tick, input);
+            PROFILE_SCOPE("stepSimulation");
+            previous = state;
+            stepSimulation(state, input, (float)dt);
+            stepped = true;
+        }
+
+        if (stepped) {
+            Snapshot& snap = snapshots.writeBuffer();
+            snap.previous = previous;
+            snap.current  = state;
+            snapshots.publish();
+        }
+
+        auto next = startTime + std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>((state.tick + 1) * dt));
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// Render one step behind the simulation and blend the two newest steps
+SimState Simulation::sample() {
+    if (snapshots.acquire()) latest = snapshots.readBuffer();
+
+    double now = std::chrono::duration<double>(Clock::now() - startTime).count() - dt;
+    double span = latest.current.time - latest.previous.time;
+    float alpha = span > 0.0 ? (float)((now - latest.previous.time) / span) : 1.0f;
+    return interpolate(latest.previous, latest.current, std::clamp(alpha, 0.0f, 1.0f));
+}
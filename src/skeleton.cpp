@@ -0,0 +1,250 @@
+#include "skeleton.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SKELETON_SIMD 1
+#endif
+
+// Tessellation of the curved parts
+static const int kSphereSlices     = 24;
+static const int kCylinderSegments = 36;
+
+// Upper bound on rig size so the solvers can keep joint matrices on the stack
+static const int kMaxJoints = 32;
+
+static void addJoint(Skeleton& s, int parent, const glm::vec3& offset, const glm::vec3& axis) {
+    s.parent.push_back(parent);
+    s.offset.push_back(offset);
+    s.axis.push_back(axis);
+}
+
+static void addPart(Skeleton& s, int joint, const glm::mat4& local,
+                    Primitive mesh, int tessellation, const glm::vec3& color) {
+    s.partJoint.push_back(joint);
+    s.partLocal.push_back(local);
+    s.partMesh.push_back(mesh);
+    s.partTessellation.push_back(tessellation);
+    s.partColor.push_back(color);
+}
+
+// Cube part: translate * scale
+static void addCube(Skeleton& s, int joint, const glm::vec3& scale,
+                    const glm::vec3& translate, const glm::vec3& color) {
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), translate);
+    addPart(s, joint, glm::scale(local, scale), Primitive::Cube, 0, color);
+}
+
+// Filled cylinder (for eyes): side tube plus two caps
+static void addFilledCylinder(Skeleton& s, int joint, const glm::mat4& local,
+                              float radius, float height, const glm::vec3& color) {
+    addPart(s, joint, glm::scale(local, glm::vec3(radius, radius, height)),
+            Primitive::Tube, kCylinderSegments, color);
+    for (float zOffset : {height * 0.5f, -height * 0.5f}) {
+        glm::mat4 cap = glm::translate(local, glm::vec3(0.0f, 0.0f, zOffset));
+        addPart(s, joint, glm::scale(cap, glm::vec3(radius, radius, 1.0f)),
+                Primitive::Disc, kCylinderSegments, color);
+    }
+}
+
+static Skeleton buildRobotSkeleton() {
+    static_assert(JOINT_COUNT <= kMaxJoints, "robot rig exceeds kMaxJoints");
+    Skeleton s;
+    const glm::vec3 none(0.0f);
+
+    // Joints (same hierarchy the robot was always drawn with)
+    addJoint(s, -1,               none,                     glm::vec3(0,1,0));  // ROOT
+    addJoint(s, JOINT_ROOT,       glm::vec3(0,0.75f,0),     none);              // TORSO
+    addJoint(s, JOINT_TORSO,      glm::vec3(0,0.5f,0),      glm::vec3(0,1,0));  // HEAD
+    addJoint(s, JOINT_TORSO,      glm::vec3(0.33f,0.05f,0), none);              // R_SHOULDER
+    addJoint(s, JOINT_R_SHOULDER, none,                     glm::vec3(0,0,1));  // R_ARM
+    addJoint(s, JOINT_TORSO,      glm::vec3(-0.33f,0.05f,0),none);              // L_SHOULDER
+    addJoint(s, JOINT_TORSO,      glm::vec3(0.16f,-0.55f,0),glm::vec3(1,0,0));  // R_LEG
+    addJoint(s, JOINT_TORSO,      glm::vec3(-0.16f,-0.55f,0),glm::vec3(1,0,0)); // L_LEG
+
+    const glm::vec3 bodyColor(0.9f,0.4f,0.2f);
+    const glm::mat4 I(1.0f);
+
+    // Torso and head
+    addCube(s, JOINT_TORSO, glm::vec3(0.6f,0.8f,0.3f), none, bodyColor);
+    addCube(s, JOINT_HEAD, glm::vec3(0.28f,0.28f,0.28f), none, bodyColor);
+
+    // Hat
+    glm::mat4 hat = glm::translate(I, glm::vec3(0.0f,0.14f,0.0f));
+    hat = glm::scale(hat, glm::vec3(0.9f));
+    addPart(s, JOINT_HEAD, glm::scale(hat, glm::vec3(0.13f,0.20f,0.13f)),
+            Primitive::Pyramid, 0, glm::vec3(1.0f,0.15f,0.15f));
+
+    // Eyes
+    const glm::vec3 eyeColor(0.05f,0.05f,0.05f);
+    float eyeR=0.045f, eyeD=0.05f;
+    s.eyeParts.push_back(s.partCount());
+    addFilledCylinder(s, JOINT_HEAD, glm::translate(I,glm::vec3(0.07f,0.05f,0.15f)), eyeR, eyeD, eyeColor);
+    s.eyeParts.push_back(s.partCount());
+    addFilledCylinder(s, JOINT_HEAD, glm::translate(I,glm::vec3(-0.07f,0.05f,0.15f)), eyeR, eyeD, eyeColor);
+
+    // Shoulder joints
+    const glm::vec3 shoulderColor(0.8f,0.3f,0.1f);
+    addPart(s, JOINT_R_SHOULDER, glm::scale(I, glm::vec3(0.09f)), Primitive::Sphere, kSphereSlices, shoulderColor);
+    addPart(s, JOINT_L_SHOULDER, glm::scale(I, glm::vec3(0.09f)), Primitive::Sphere, kSphereSlices, shoulderColor);
+
+    // Arms
+    addCube(s, JOINT_R_ARM, glm::vec3(0.45f,0.14f,0.14f), glm::vec3(0.23f,0,0), bodyColor);
+    addCube(s, JOINT_L_SHOULDER, glm::vec3(0.45f,0.14f,0.14f), glm::vec3(-0.23f,0,0), bodyColor);
+
+    // Legs
+    const glm::vec3 legColor(0.7f,0.35f,0.15f);
+    addCube(s, JOINT_R_LEG, glm::vec3(0.22f,0.50f,0.22f), none, legColor);
+    addCube(s, JOINT_L_LEG, glm::vec3(0.22f,0.50f,0.22f), none, legColor);
+    return s;
+}
+
+const Skeleton& robotSkeleton() {
+    static const Skeleton skeleton = buildRobotSkeleton();
+    return skeleton;
+}
+
+void SkeletonPose::resize(const Skeleton& skeleton, int n) {
+    count  = n;
+    padded = (n + 3) & ~3;
+    angle.assign(skeleton.jointCount() * padded, 0.0f);
+    for (auto& axis : rootPos) axis.assign(padded, 0.0f);
+}
+
+#if SKELETON_SIMD
+
+// Affine matrices of 4 robots at once: m[column][row], rows 0..2 (row 3 is 0,0,0,1)
+struct Affine4 {
+    __m128 m[4][3];
+};
+
+// world = parent * (translate(off) * rotate(axis, angle)) for 4 robots
+static void composeJoint(const Affine4& P, const __m128 off[3], const glm::vec3& axis,
+                         __m128 c, __m128 s, bool rotates, Affine4& W) {
+    if (rotates) {
+        // Rodrigues rotation, column-major like glm::rotate
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 t  = _mm_sub_ps(one, c);
+        __m128 ax = _mm_set1_ps(axis.x), ay = _mm_set1_ps(axis.y), az = _mm_set1_ps(axis.z);
+        __m128 tx = _mm_mul_ps(t, ax), ty = _mm_mul_ps(t, ay), tz = _mm_mul_ps(t, az);
+        __m128 R[3][3];
+        R[0][0] = _mm_add_ps(c, _mm_mul_ps(tx, ax));
+        R[0][1] = _mm_add_ps(_mm_mul_ps(tx, ay), _mm_mul_ps(s, az));
+        R[0][2] = _mm_sub_ps(_mm_mul_ps(tx, az), _mm_mul_ps(s, ay));
+        R[1][0] = _mm_sub_ps(_mm_mul_ps(ty, ax), _mm_mul_ps(s, az));
+        R[1][1] = _mm_add_ps(c, _mm_mul_ps(ty, ay));
+        R[1][2] = _mm_add_ps(_mm_mul_ps(ty, az), _mm_mul_ps(s, ax));
+        R[2][0] = _mm_add_ps(_mm_mul_ps(tz, ax), _mm_mul_ps(s, ay));
+        R[2][1] = _mm_sub_ps(_mm_mul_ps(tz, ay), _mm_mul_ps(s, ax));
+        R[2][2] = _mm_add_ps(c, _mm_mul_ps(tz, az));
+
+        for (int col = 0; col < 3; ++col)
+            for (int row = 0; row < 3; ++row)
+                W.m[col][row] = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(P.m[0][row], R[col][0]),
+                    _mm_mul_ps(P.m[1][row], R[col][1])),
+                    _mm_mul_ps(P.m[2][row], R[col][2]));
+    } else {
+        for (int col = 0; col < 3; ++col)
+            for (int row = 0; row < 3; ++row)
+                W.m[col][row] = P.m[col][row];
+    }
+    for (int row = 0; row < 3; ++row)
+        W.m[3][row] = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(P.m[0][row], off[0]),
+            _mm_mul_ps(P.m[1][row], off[1])),
+            _mm_add_ps(_mm_mul_ps(P.m[2][row], off[2]), P.m[3][row]));
+}
+
+// Write jointWorld * local for 4 robots as 4 column-major glm::mat4
+static void storePart(const Affine4& J, const glm::mat4& local, glm::mat4* out, int stride) {
+    __m128 col[4][4];
+    for (int c = 0; c < 4; ++c) {
+        for (int row = 0; row < 3; ++row) {
+            __m128 v = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(J.m[0][row], _mm_set1_ps(local[c][0])),
+                _mm_mul_ps(J.m[1][row], _mm_set1_ps(local[c][1]))),
+                _mm_mul_ps(J.m[2][row], _mm_set1_ps(local[c][2])));
+            if (c == 3) v = _mm_add_ps(v, J.m[3][row]);
+            col[c][row] = v;
+        }
+        col[c][3] = _mm_set1_ps(c == 3 ? 1.0f : 0.0f);
+
+        // 4 rows x 4 robots -> 4 robots x 4 rows
+        _MM_TRANSPOSE4_PS(col[c][0], col[c][1], col[c][2], col[c][3]);
+        for (int lane = 0; lane < 4; ++lane)
+            _mm_storeu_ps(&out[lane * stride][c][0], col[c][lane]);
+    }
+}
+
+void solveForwardKinematics(const Skeleton& skeleton, const SkeletonPose& pose,
+                            int begin, int end, glm::mat4* partWorld) {
+    const int joints = skeleton.jointCount();
+    const int parts  = skeleton.partCount();
+    Affine4 world[kMaxJoints];
+
+    alignas(16) float cs[4] = {}, sn[4] = {};
+    for (int r = begin; r < end; r += 4) {
+        for (int j = 0; j < joints; ++j) {
+            bool rotates = skeleton.axis[j] != glm::vec3(0.0f);
+            if (rotates) {
+                const float* a = pose.angles(j) + r;
+                for (int lane = 0; lane < 4; ++lane) {
+                    cs[lane] = std::cos(a[lane]);
+                    sn[lane] = std::sin(a[lane]);
+                }
+            }
+            __m128 c = _mm_load_ps(cs), s = _mm_load_ps(sn);
+
+            const glm::vec3& o = skeleton.offset[j];
+            __m128 off[3] = {_mm_set1_ps(o.x), _mm_set1_ps(o.y), _mm_set1_ps(o.z)};
+
+            int p = skeleton.parent[j];
+            if (p < 0) {
+                // Root: identity parent, per-robot translation
+                Affine4 I;
+                const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+                for (int col = 0; col < 3; ++col)
+                    for (int row = 0; row < 3; ++row)
+                        I.m[col][row] = col == row ? one : zero;
+                I.m[3][0] = _mm_loadu_ps(pose.rootX() + r);
+                I.m[3][1] = _mm_loadu_ps(pose.rootY() + r);
+                I.m[3][2] = _mm_loadu_ps(pose.rootZ() + r);
+                composeJoint(I, off, skeleton.axis[j], c, s, rotates, world[j]);
+            } else {
+                composeJoint(world[p], off, skeleton.axis[j], c, s, rotates, world[j]);
+            }
+        }
+
+        glm::mat4* out = partWorld + (size_t)r * parts;
+        for (int k = 0; k < parts; ++k)
+            storePart(world[skeleton.partJoint[k]], skeleton.partLocal[k], out + k, parts);
+    }
+}
+
+#else
+
+// Portable path: one robot at a time with glm
+void solveForwardKinematics(const Skeleton& skeleton, const SkeletonPose& pose,
+                            int begin, int end, glm::mat4* partWorld) {
+    const int joints = skeleton.jointCount();
+    const int parts  = skeleton.partCount();
+    glm::mat4 world[kMaxJoints];
+
+    for (int r = begin; r < end; ++r) {
+        for (int j = 0; j < joints; ++j) {
+            int p = skeleton.parent[j];
+            glm::mat4 parent = p < 0
+                ? glm::translate(glm::mat4(1.0f), glm::vec3(pose.rootX()[r], pose.rootY()[r], pose.rootZ()[r]))
+                : world[p];
+            world[j] = glm::translate(parent, skeleton.offset[j]);
+            if (skeleton.axis[j] != glm::vec3(0.0f))
+                world[j] = glm::rotate(world[j], pose.angles(j)[r], skeleton.axis[j]);
+        }
+        for (int k = 0; k < parts; ++k)
+            partWorld[(size_t)r * parts + k] = world[skeleton.partJoint[k]] * skeleton.partLocal[k];
+    }
+}
+
+#endif
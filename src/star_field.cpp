@@ -0,0 +1,40 @@
+#include "star_field.h"
+#include <algorithm>
+
+StarField::StarField()
+    : vao(0), stars(5000), innerRadius(30.0f), outerRadius(80.0f) {}
+
+void StarField::initGPU() {
+    if (!vao) glGenVertexArrays(1, &vao);
+}
+
+void StarField::destroyGPU() {
+    if (vao) glDeleteVertexArrays(1, &vao);
+    vao = 0;
+}
+
+void StarField::setCount(int count) { stars = std::max(count, 0); }
+
+AABB StarField::bounds() const {
+    AABB b;
+    b.min = glm::vec3(-outerRadius);
+    b.max = glm::vec3(outerRadius);
+    return b;
+}
+
+void StarField::draw(Shader& shader, float tSeconds) {
+    if (stars == 0) return;
+    initGPU();
+
+    shader.use();
+    shader.setFloat("uTime", tSeconds);
+    shader.setFloat("uInnerRadius", innerRadius);
+    shader.setFloat("uOuterRadius", outerRadius);
+
+    // Per-star size comes from gl_PointSize
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_POINTS, 0, stars);
+    glBindVertexArray(0);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+}
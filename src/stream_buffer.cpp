@@ -0,0 +1,138 @@
+#include "stream_buffer.h"
+#include <cstring>
+#include <iostream>
+
+// GL 4.4 pieces the bundled (4.1) loader does not provide
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP PFNBUFFERSTORAGE)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+static PFNBUFFERSTORAGE bufferStorage = nullptr;
+
+bool StreamBuffer::loadEntryPoints(GLADloadproc load) {
+    if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 4)) return false;
+    bufferStorage = (PFNBUFFERSTORAGE)load("glBufferStorage");
+    return bufferStorage != nullptr;
+}
+
+bool StreamBuffer::persistentAvailable() { return bufferStorage != nullptr; }
+
+StreamBuffer::StreamBuffer()
+    : target(GL_ARRAY_BUFFER), name(0), regionSize(0), wantPersistent(true), mapped(nullptr),
+      fences{}, region(0), head(0), frameStarted(false), waits(0) {}
+
+void StreamBuffer::init(GLenum bufferTarget, GLsizeiptr regionBytes, bool persistent) {
+    destroy();
+    target         = bufferTarget;
+    wantPersistent = persistent;
+    create(regionBytes);
+}
+
+void StreamBuffer::destroy() {
+    release();
+    regionSize = 0;
+    waits = 0;
+}
+
+void StreamBuffer::create(GLsizeiptr regionBytes) {
+    regionSize = regionBytes;
+    region = 0;
+    head = 0;
+    frameStarted = false;
+
+    glGenBuffers(1, &name);
+    glBindBuffer(target, name);
+    if (wantPersistent && bufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr total = regionSize * kStreamRegions;
+        bufferStorage(target, total, nullptr, flags);
+        mapped = (char*)glMapBufferRange(target, 0, total, flags);
+        if (!mapped) {
+            // Immutable storage cannot be orphaned: fall back on a new buffer
+            // and stop asking for persistent mapping on later grows
+            std::cerr << "StreamBuffer: persistent mapping failed, using glBufferSubData\n";
+            wantPersistent = false;
+            glBindBuffer(target, 0);
+            glDeleteBuffers(1, &name);
+            glGenBuffers(1, &name);
+            glBindBuffer(target, name);
+        }
+    }
+    if (!mapped) glBufferData(target, regionSize, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(target, 0);
+}
+
+void StreamBuffer::release() {
+    for (GLsync& f : fences) {
+        if (f) glDeleteSync(f);
+        f = nullptr;
+    }
+    if (mapped) {
+        glBindBuffer(target, name);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+        mapped = nullptr;
+    }
+    if (name) glDeleteBuffers(1, &name);
+    name = 0;
+}
+
+// First write of a frame: make sure the GPU is done with the region
+void StreamBuffer::beginFrame() {
+    frameStarted = true;
+    head = 0;
+    if (!mapped) {
+        // Orphan: the driver hands out fresh storage if the old is still in use
+        glBindBuffer(target, name);
+        glBufferData(target, regionSize, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+    GLsync& fence = fences[region];
+    if (!fence) return;
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        ++waits;
+        do result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+GLintptr StreamBuffer::write(const void* data, GLsizeiptr bytes, GLsizeiptr align) {
+    if (!frameStarted) beginFrame();
+
+    GLsizeiptr offset = (head + align - 1) / align * align;
+    if (offset + bytes > regionSize) {
+        // Too small for this frame: start over in a buffer with room for it.
+        // Draws already issued keep reading the old storage.
+        GLsizeiptr size = regionSize > 0 ? regionSize : bytes;
+        while (size < bytes) size *= 2;
+        release();
+        create(size * 2);
+        beginFrame();
+        offset = 0;
+    }
+
+    GLintptr base = mapped ? (GLintptr)region * regionSize : 0;
+    if (mapped) {
+        std::memcpy(mapped + base + offset, data, (size_t)bytes);
+    } else {
+        glBindBuffer(target, name);
+        glBufferSubData(target, offset, bytes, data);
+    }
+    head = offset + bytes;
+    return base + offset;
+}
+
+void StreamBuffer::endFrame() {
+    if (!frameStarted) return;
+    if (mapped) {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % kStreamRegions;
+    }
+    frameStarted = false;
+}
@@ -0,0 +1,311 @@
+#include "vegetation.h"
+#include "profiler.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Plants stay out of the platform the robot walks on
+static const float kClearingRadius = 3.0f;
+
+Vegetation::Vegetation()
+    : frame(0), vao(0), busy(false), quit(false) {}
+
+Vegetation::~Vegetation() {
+    stopWorker();
+}
+
+std::uint64_t Vegetation::key(int x, int z) {
+    return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)z;
+}
+
+void Vegetation::configure(const VegetationSettings& settings) {
+    destroyGPU();
+    config   = settings;
+    counters = VegetationStats();
+}
+
+void Vegetation::initGPU() {
+    if (vao) return;
+    meshes[GROUND_TILE] = meshRegistry().get(Primitive::Quad);
+    meshes[BUSH]        = meshRegistry().get(Primitive::Sphere, 6);
+    meshes[TRUNK]       = meshRegistry().get(Primitive::Tube, 6);
+    meshes[CANOPY]      = meshRegistry().get(Primitive::Pyramid);
+
+    vao = meshRegistry().makeVertexArray();
+    enableInstanceAttributes();
+    glBindVertexArray(0);
+}
+
+void Vegetation::stopWorker() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    worker.join();
+    quit = false;
+    busy = false;
+    requests.clear();
+    done.clear();
+}
+
+void Vegetation::destroyGPU() {
+    stopWorker();
+    for (auto& entry : chunks) glDeleteBuffers(1, &entry.second.vbo);
+    chunks.clear();
+    queued.clear();
+    visible.clear();
+    if (vao) glDeleteVertexArrays(1, &vao);
+    vao = 0;
+    counters.residentChunks = 0;
+    counters.residentBytes  = 0;
+}
+
+// ------------------------------------------------
+// Worker: deterministic placement
+// ------------------------------------------------
+
+// Small counter-based generator; the stream depends only on its seed
+struct PlacementRandom {
+    std::uint32_t state;
+
+    std::uint32_t next() {
+        // lowbias32 over a Weyl sequence
+        std::uint32_t x = (state += 0x9e3779b9u);
+        x ^= x >> 16; x *= 0x7feb352du;
+        x ^= x >> 15; x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+    float unit() { return (next() >> 8) * (1.0f / 16777216.0f); }
+    float range(float lo, float hi) { return lo + (hi - lo) * unit(); }
+};
+
+static InstanceData makeInstance(const glm::mat4& model, const glm::vec3& color) {
+    return {model, glm::inverseTranspose(glm::mat3(model)), color};
+}
+
+Vegetation::Generated Vegetation::generate(const VegetationSettings& settings, std::uint64_t chunkKey) {
+    auto start = std::chrono::steady_clock::now();
+
+    const int   cx   = (int)(std::int32_t)(chunkKey >> 32);
+    const int   cz   = (int)(std::int32_t)(chunkKey & 0xffffffffu);
+    const float size = settings.chunkSize;
+    const glm::vec3 corner(cx * size, 0.0f, cz * size);
+
+    // Unsigned so the hash wraps instead of overflowing far from the origin
+    PlacementRandom rng{settings.seed ^ ((std::uint32_t)cx * 73856093u) ^ ((std::uint32_t)cz * 19349663u)};
+    rng.next();
+
+    Generated g;
+    g.key = chunkKey;
+    g.bounds.expand(corner);
+    g.bounds.expand(corner + glm::vec3(size, 0.0f, size));
+
+    // Ground tile under the whole chunk (the quad spans [-1, 1])
+    glm::mat4 tile = glm::translate(glm::mat4(1.0f), corner + glm::vec3(size * 0.5f, 0.0f, size * 0.5f));
+    tile = glm::scale(tile, glm::vec3(size * 0.5f, 1.0f, size * 0.5f));
+    g.instances[GROUND_TILE].push_back(makeInstance(tile, glm::vec3(0.20f, 0.75f, 0.20f)));
+
+    g.instances[BUSH].reserve(settings.plantsPerChunk);
+    for (int i = 0; i < settings.plantsPerChunk; ++i) {
+        glm::vec3 pos = corner + glm::vec3(rng.unit() * size, 0.0f, rng.unit() * size);
+        bool tree     = rng.unit() < 0.2f;
+        float shade   = rng.range(0.8f, 1.2f);
+        if (glm::length(glm::vec3(pos.x, 0.0f, pos.z)) < kClearingRadius) continue;
+
+        if (!tree) {
+            // Half-buried squashed sphere
+            float r = rng.range(0.3f, 0.8f);
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), pos);
+            m = glm::scale(m, glm::vec3(r, r * 0.7f, r));
+            g.instances[BUSH].push_back(makeInstance(m, glm::vec3(0.10f, 0.50f, 0.15f) * shade));
+            g.bounds.expand(pos + glm::vec3(0.0f, r * 0.7f, 0.0f));
+            continue;
+        }
+
+        // Trunk: the tube runs along Z, stand it up along Y
+        float height = rng.range(2.0f, 5.0f);
+        float radius = rng.range(0.12f, 0.25f);
+        glm::mat4 trunk = glm::translate(glm::mat4(1.0f), pos + glm::vec3(0.0f, height * 0.5f, 0.0f));
+        trunk = glm::rotate(trunk, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+        trunk = glm::scale(trunk, glm::vec3(radius, radius, height));
+        g.instances[TRUNK].push_back(makeInstance(trunk, glm::vec3(0.35f, 0.22f, 0.10f) * shade));
+
+        // Canopy: pyramid from 60% of the trunk up past its top
+        float width = rng.range(1.0f, 2.0f);
+        glm::mat4 canopy = glm::translate(glm::mat4(1.0f), pos + glm::vec3(0.0f, height * 0.6f, 0.0f));
+        canopy = glm::scale(canopy, glm::vec3(width, height * 0.8f, width));
+        g.instances[CANOPY].push_back(makeInstance(canopy, glm::vec3(0.05f, 0.40f, 0.10f) * shade));
+        g.bounds.expand(pos + glm::vec3(0.0f, height * 1.4f, 0.0f));
+    }
+    // Plants near the edge reach over it
+    g.bounds.min -= glm::vec3(2.0f, 0.0f, 2.0f);
+    g.bounds.max += glm::vec3(2.0f, 0.0f, 2.0f);
+
+    g.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return g;
+}
+
+bool Vegetation::sameChunkTwice(const VegetationSettings& settings, int x, int z) {
+    Generated a = generate(settings, key(x, z));
+    Generated b = generate(settings, key(x, z));
+    for (int k = 0; k < kKinds; ++k) {
+        if (a.instances[k].size() != b.instances[k].size()) return false;
+        if (!a.instances[k].empty() &&
+            std::memcmp(a.instances[k].data(), b.instances[k].data(), a.instances[k].size() * sizeof(InstanceData)) != 0)
+            return false;
+    }
+    return true;
+}
+
+void Vegetation::workerLoop() {
+    PROFILE_THREAD_NAME("vegetation");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return quit || !requests.empty(); });
+        if (quit) return;
+
+        std::uint64_t next = requests.front();
+        requests.pop_front();
+        VegetationSettings settings = config;
+        busy = true;
+        lock.unlock();
+
+        Generated g;
+        {
+            PROFILE_SCOPE("Vegetation::generate");
+            g = generate(settings, next);
+        }
+
+        lock.lock();
+        done.push_back(std::move(g));
+        busy = false;
+        idle.notify_all();
+    }
+}
+
+void Vegetation::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return requests.empty() && !busy; });
+}
+
+// ------------------------------------------------
+// GL thread: requests, uploads, eviction, drawing
+// ------------------------------------------------
+void Vegetation::update(const glm::vec3& eye, std::pmr::memory_resource* scratch) {
+    initGPU();
+    if (!worker.joinable()) worker = std::thread(&Vegetation::workerLoop, this);
+    ++frame;
+
+    // Chunks in the square around the camera, nearest first
+    const int cx = (int)std::floor(eye.x / config.chunkSize);
+    const int cz = (int)std::floor(eye.z / config.chunkSize);
+    const int n  = config.viewChunks;
+    std::pmr::vector<std::pair<int, std::uint64_t>> wanted(scratch);
+    wanted.reserve((size_t)(2 * n + 1) * (2 * n + 1));
+    for (int z = cz - n; z <= cz + n; ++z)
+        for (int x = cx - n; x <= cx + n; ++x)
+            wanted.push_back({(x - cx) * (x - cx) + (z - cz) * (z - cz), key(x, z)});
+    std::sort(wanted.begin(), wanted.end());
+
+    std::vector<Generated> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Requests the camera moved away from are dropped; the one in flight still lands
+        for (std::uint64_t k : requests) queued.erase(k);
+        requests.clear();
+        for (const auto& w : wanted) {
+            auto it = chunks.find(w.second);
+            if (it != chunks.end()) it->second.lastUsed = frame;
+            else if (queued.insert(w.second).second) requests.push_back(w.second);
+        }
+        finished.swap(done);
+    }
+    wake.notify_one();
+
+    for (Generated& g : finished) upload(g);
+    evict();
+}
+
+void Vegetation::upload(Generated& g) {
+    queued.erase(g.key);
+    counters.generatedChunks += 1;
+    counters.generateMsTotal += g.ms;
+    counters.generateMsMax    = std::max(counters.generateMsMax, g.ms);
+    if (chunks.count(g.key)) return;
+
+    Chunk c;
+    c.bounds   = g.bounds;
+    c.bytes    = 0;
+    c.lastUsed = frame;
+    for (int k = 0; k < kKinds; ++k) {
+        c.offset[k] = (GLintptr)c.bytes;
+        c.count[k]  = (GLsizei)g.instances[k].size();
+        c.bytes    += g.instances[k].size() * sizeof(InstanceData);
+    }
+
+    // Built once, never rewritten: static storage
+    glGenBuffers(1, &c.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, c.vbo);
+    glBufferData(GL_ARRAY_BUFFER, c.bytes, nullptr, GL_STATIC_DRAW);
+    for (int k = 0; k < kKinds; ++k)
+        if (c.count[k])
+            glBufferSubData(GL_ARRAY_BUFFER, c.offset[k], c.count[k] * sizeof(InstanceData), g.instances[k].data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    chunks.emplace(g.key, c);
+    counters.residentChunks += 1;
+    counters.residentBytes  += c.bytes;
+}
+
+// Drop least recently used chunks until under budget; chunks around the
+// camera right now are never dropped
+void Vegetation::evict() {
+    while (counters.residentBytes > config.memoryBudget) {
+        auto oldest = chunks.end();
+        for (auto it = chunks.begin(); it != chunks.end(); ++it)
+            if (it->second.lastUsed < frame && (oldest == chunks.end() || it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+        if (oldest == chunks.end()) break;
+
+        glDeleteBuffers(1, &oldest->second.vbo);
+        counters.residentChunks -= 1;
+        counters.residentBytes  -= oldest->second.bytes;
+        counters.evictedChunks  += 1;
+        chunks.erase(oldest);
+    }
+}
+
+void Vegetation::draw(const Frustum& frustum) {
+    counters.visibleChunks = 0;
+    counters.instances     = 0;
+    counters.drawCalls     = 0;
+    if (!vao) return;
+
+    visible.clear();
+    for (const auto& entry : chunks)
+        if (frustum.visible(entry.second.bounds)) visible.push_back(&entry.second);
+    counters.visibleChunks = (int)visible.size();
+
+    // One instanced call per (chunk, kind), all through the same VAO
+    glBindVertexArray(vao);
+    for (int k = 0; k < kKinds; ++k) {
+        for (const Chunk* c : visible) {
+            if (!c->count[k]) continue;
+            glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
+            setInstanceLayout(c->offset[k]);
+            glDrawElementsInstancedBaseVertex(meshes[k].mode, meshes[k].count, GL_UNSIGNED_INT,
+                                              (void*)(meshes[k].firstIndex * sizeof(GLuint)),
+                                              c->count[k], meshes[k].baseVertex);
+            counters.instances += c->count[k];
+            ++counters.drawCalls;
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}